@@ -21,6 +21,8 @@ public:
 
     // Optional methods that some implementations might support
     virtual QByteArray readAndClear() { return QByteArray(); }
+    // Data written since the given offset, leaving the buffer intact
+    virtual QByteArray readFrom(qint64 offset) const { return getData().mid(offset); }
     virtual bool isFull() const { return false; }
     virtual int availableSpace() const { return 0; }
 
@@ -0,0 +1,133 @@
+#include "audiochunker.h"
+#include <QtEndian>
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    const int kBytesPerSample = 2;
+}
+
+AudioChunker::AudioChunker(int sampleRate)
+    : m_sampleRate(sampleRate), m_maxChunkMs(15000), m_minChunkMs(8000), m_overlapMs(400), m_silenceWindowMs(30)
+{
+}
+
+void AudioChunker::setMaxChunkMs(int ms)
+{
+    m_maxChunkMs = ms;
+}
+
+void AudioChunker::setMinChunkMs(int ms)
+{
+    m_minChunkMs = ms;
+}
+
+void AudioChunker::setOverlapMs(int ms)
+{
+    m_overlapMs = ms;
+}
+
+int AudioChunker::maxChunkMs() const
+{
+    return m_maxChunkMs;
+}
+
+qsizetype AudioChunker::msToBytes(int ms) const
+{
+    return static_cast<qsizetype>(ms) * m_sampleRate / 1000 * kBytesPerSample;
+}
+
+QList<AudioChunker::Chunk> AudioChunker::split(const QByteArray &pcm) const
+{
+    QList<Chunk> chunks;
+    const qsizetype total = pcm.size() - (pcm.size() % kBytesPerSample);
+    const qsizetype maxBytes = msToBytes(m_maxChunkMs);
+    const qsizetype minBytes = qMin(msToBytes(m_minChunkMs), maxBytes);
+    const qsizetype overlapBytes = qMin(msToBytes(m_overlapMs), minBytes / 2);
+
+    qsizetype start = 0;
+    while (total - start > maxBytes)
+    {
+        qsizetype cut = findQuietestPoint(pcm, start + minBytes, start + maxBytes);
+        chunks.append({start, cut - start});
+        start = cut - overlapBytes;
+    }
+
+    chunks.append({start, total - start});
+    return chunks;
+}
+
+qsizetype AudioChunker::findQuietestPoint(const QByteArray &pcm, qsizetype begin, qsizetype end) const
+{
+    const qsizetype windowBytes = qMax<qsizetype>(msToBytes(m_silenceWindowMs), kBytesPerSample);
+    const uchar *samples = reinterpret_cast<const uchar *>(pcm.constData());
+
+    qsizetype bestPoint = end;
+    double bestEnergy = std::numeric_limits<double>::max();
+
+    for (qsizetype frame = begin; frame + windowBytes <= end; frame += windowBytes)
+    {
+        double energy = 0.0;
+        for (qsizetype i = frame; i < frame + windowBytes; i += kBytesPerSample)
+        {
+            const double sample = qFromLittleEndian<qint16>(samples + i);
+            energy += sample * sample;
+        }
+
+        // Prefer later frames on ties so chunks stay close to the maximum size
+        if (energy <= bestEnergy)
+        {
+            bestEnergy = energy;
+            bestPoint = frame + windowBytes / 2;
+        }
+    }
+
+    return bestPoint - (bestPoint % kBytesPerSample);
+}
+
+QString AudioChunker::stitch(const QStringList &parts, int maxOverlapWords)
+{
+    QStringList words;
+
+    for (const QString &part : parts)
+    {
+        const QStringList next = part.simplified().split(' ', Qt::SkipEmptyParts);
+
+        // Find the longest run of words that ends the text so far and starts this part
+        qsizetype overlap = 0;
+        const qsizetype limit = std::min({static_cast<qsizetype>(maxOverlapWords), words.size(), next.size()});
+        for (qsizetype k = limit; k > 0 && overlap == 0; --k)
+        {
+            bool matches = true;
+            for (qsizetype i = 0; i < k && matches; ++i)
+            {
+                const QString tail = normalizeWord(words.at(words.size() - k + i));
+                matches = !tail.isEmpty() && tail == normalizeWord(next.at(i));
+            }
+
+            if (matches)
+            {
+                overlap = k;
+            }
+        }
+
+        words += next.mid(overlap);
+    }
+
+    return words.join(' ');
+}
+
+QString AudioChunker::normalizeWord(const QString &word)
+{
+    QString normalized;
+    normalized.reserve(word.size());
+    for (const QChar c : word)
+    {
+        if (c.isLetterOrNumber())
+        {
+            normalized.append(c.toLower());
+        }
+    }
+    return normalized;
+}
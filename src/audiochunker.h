@@ -0,0 +1,46 @@
+#ifndef AUDIOCHUNKER_H
+#define AUDIOCHUNKER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Splits long 16-bit mono PCM recordings at the quietest point inside a
+// bounded window so each piece can be transcribed independently, and stitches
+// the resulting texts back together.
+class AudioChunker
+{
+public:
+    struct Chunk
+    {
+        qsizetype offset;
+        qsizetype length;
+    };
+
+    explicit AudioChunker(int sampleRate = 24000);
+
+    void setMaxChunkMs(int ms);
+    void setMinChunkMs(int ms);
+    void setOverlapMs(int ms);
+    int maxChunkMs() const;
+
+    // Returns a single chunk covering the whole buffer if it is short enough
+    QList<Chunk> split(const QByteArray &pcm) const;
+
+    // Joins chunk transcripts in order, dropping words repeated in the overlap
+    static QString stitch(const QStringList &parts, int maxOverlapWords = 8);
+
+private:
+    int m_sampleRate;
+    int m_maxChunkMs;
+    int m_minChunkMs;
+    int m_overlapMs;
+    int m_silenceWindowMs;
+
+    qsizetype msToBytes(int ms) const;
+    qsizetype findQuietestPoint(const QByteArray &pcm, qsizetype begin, qsizetype end) const;
+    static QString normalizeWord(const QString &word);
+};
+
+#endif // AUDIOCHUNKER_H
@@ -0,0 +1,120 @@
+#include "audiomessageencoder.h"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_SSSE3_BASE64 1
+#endif
+
+namespace
+{
+    const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const char kAppendPrefix[] = "{\"type\":\"input_audio_buffer.append\",\"audio\":\"";
+    const char kAppendSuffix[] = "\"}";
+
+    qsizetype base64Scalar(const uchar *in, qsizetype size, char *out)
+    {
+        char *start = out;
+        qsizetype i = 0;
+        for (; i + 3 <= size; i += 3)
+        {
+            const uint value = (uint(in[i]) << 16) | (uint(in[i + 1]) << 8) | in[i + 2];
+            *out++ = kAlphabet[(value >> 18) & 63];
+            *out++ = kAlphabet[(value >> 12) & 63];
+            *out++ = kAlphabet[(value >> 6) & 63];
+            *out++ = kAlphabet[value & 63];
+        }
+
+        if (i < size)
+        {
+            uint value = uint(in[i]) << 16;
+            if (i + 1 < size)
+            {
+                value |= uint(in[i + 1]) << 8;
+            }
+            *out++ = kAlphabet[(value >> 18) & 63];
+            *out++ = kAlphabet[(value >> 12) & 63];
+            *out++ = i + 1 < size ? kAlphabet[(value >> 6) & 63] : '=';
+            *out++ = '=';
+        }
+
+        return out - start;
+    }
+
+#ifdef HAVE_SSSE3_BASE64
+    // Encodes 12 input bytes into 16 characters per iteration: shuffle the
+    // bytes into place, split them into 6-bit indices with two multiplies,
+    // then map the indices to ASCII through a 16-entry offset table.
+    __attribute__((target("ssse3"))) qsizetype base64Ssse3(const uchar *in, qsizetype size, char *out)
+    {
+        const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+        const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                              '/' - 63, 'A', 0, 0);
+        char *start = out;
+        qsizetype i = 0;
+
+        // Each load reads 16 bytes but only consumes 12
+        for (; i + 16 <= size; i += 12)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+            bytes = _mm_shuffle_epi8(bytes, shuffle);
+
+            const __m128i high = _mm_mulhi_epu16(_mm_and_si128(bytes, _mm_set1_epi32(0x0fc0fc00)),
+                                                 _mm_set1_epi32(0x04000040));
+            const __m128i low = _mm_mullo_epi16(_mm_and_si128(bytes, _mm_set1_epi32(0x003f03f0)),
+                                                _mm_set1_epi32(0x01000010));
+            const __m128i indices = _mm_or_si128(high, low);
+
+            __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+            const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+            range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+
+            const __m128i ascii = _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), ascii);
+            out += 16;
+        }
+
+        return (out - start) + base64Scalar(in + i, size - i, out);
+    }
+#endif
+}
+
+AudioMessageEncoder::AudioMessageEncoder()
+{
+}
+
+qsizetype AudioMessageEncoder::base64Size(qsizetype size)
+{
+    return (size + 2) / 3 * 4;
+}
+
+qsizetype AudioMessageEncoder::base64Encode(const uchar *in, qsizetype size, char *out)
+{
+#ifdef HAVE_SSSE3_BASE64
+    static const bool hasSsse3 = __builtin_cpu_supports("ssse3");
+    if (hasSsse3)
+    {
+        return base64Ssse3(in, size, out);
+    }
+#endif
+    return base64Scalar(in, size, out);
+}
+
+const QByteArray &AudioMessageEncoder::encodeAppend(const char *pcm, qsizetype size)
+{
+    const qsizetype prefixSize = sizeof(kAppendPrefix) - 1;
+    const qsizetype suffixSize = sizeof(kAppendSuffix) - 1;
+    const qsizetype total = prefixSize + base64Size(size) + suffixSize;
+
+    // resize() keeps the capacity, so steady-state frames do not allocate
+    m_buffer.resize(total);
+    char *out = m_buffer.data();
+
+    std::memcpy(out, kAppendPrefix, prefixSize);
+    out += prefixSize;
+    out += base64Encode(reinterpret_cast<const uchar *>(pcm), size, out);
+    std::memcpy(out, kAppendSuffix, suffixSize);
+
+    return m_buffer;
+}
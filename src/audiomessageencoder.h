@@ -0,0 +1,24 @@
+#ifndef AUDIOMESSAGEENCODER_H
+#define AUDIOMESSAGEENCODER_H
+
+#include <QByteArray>
+
+// Builds input_audio_buffer.append messages for the Realtime API directly in
+// a reusable buffer, base64-encoding the PCM with a vectorized kernel where
+// the CPU supports it.
+class AudioMessageEncoder
+{
+public:
+    AudioMessageEncoder();
+
+    // The returned buffer is reused by the next call
+    const QByteArray &encodeAppend(const char *pcm, qsizetype size);
+
+    static qsizetype base64Encode(const uchar *in, qsizetype size, char *out);
+    static qsizetype base64Size(qsizetype size);
+
+private:
+    QByteArray m_buffer;
+};
+
+#endif // AUDIOMESSAGEENCODER_H
@@ -13,23 +13,44 @@
 #include "fixedbufferdevice.h"
 
 AudioRecorder::AudioRecorder(QObject *parent)
-    : QObject(parent), m_audioInput(nullptr), m_audioSource(nullptr), m_audioBuffer(nullptr), m_isRecording(false), m_transcriber(nullptr), m_currentDevice(QMediaDevices::defaultAudioInput())
+    : QObject(parent), m_audioInput(nullptr), m_audioSource(nullptr), m_audioBuffer(nullptr), m_isRecording(false), m_transcriber(nullptr), m_realtimeThread(new QThread(this)), m_currentDevice(QMediaDevices::defaultAudioInput())
 {
     setupAudioInput();
 
-    // Create OpenAI transcriber
-    m_transcriber = new OpenAITranscriberRealtime(this);
+    // Create OpenAI transcriber; the realtime session runs on its own thread
+    m_transcriber = new OpenAITranscriberRealtime();
     m_transcriber->setAudioBuffer(m_audioBuffer);
 
+    m_realtimeThread->setObjectName("RealtimeThread");
+    m_transcriber->moveToThread(m_realtimeThread);
+    connect(m_realtimeThread, &QThread::finished, m_transcriber, &QObject::deleteLater);
+    m_realtimeThread->start();
+
     // Connect transcriber signals
     connect(m_transcriber, &OpenAITranscriberRealtime::transcriptionReceived,
             this, &AudioRecorder::transcriptionReceived);
+    connect(m_transcriber, &OpenAITranscriberRealtime::transcriptionDelta,
+            this, &AudioRecorder::transcriptionDelta);
+    connect(m_transcriber, &OpenAITranscriberRealtime::transcriptionRevised,
+            this, &AudioRecorder::transcriptionRevised);
     connect(m_transcriber, &OpenAITranscriberRealtime::transcriptionError,
             this, &AudioRecorder::transcriptionError);
+    connect(m_transcriber, &OpenAITranscriberRealtime::networkLagChanged,
+            this, &AudioRecorder::realtimeLagChanged);
+    connect(m_transcriber, &OpenAITranscriberRealtime::batchFallbackRequested,
+            this, &AudioRecorder::realtimeFallbackAudio);
+    connect(m_transcriber, &OpenAITranscriberRealtime::utteranceTranscribed,
+            this, &AudioRecorder::realtimeUtteranceTranscribed);
 }
 
 AudioRecorder::~AudioRecorder()
 {
+    // The transcriber reads from the buffer while it streams, so it is
+    // stopped and deleted on its thread before the buffer goes away
+    m_realtimeThread->quit();
+    m_realtimeThread->wait();
+    m_transcriber = nullptr;
+
     if (m_isRecording)
     {
         stopRecording();
@@ -55,11 +76,6 @@ AudioRecorder::~AudioRecorder()
         m_audioBuffer = nullptr;
     }
 
-    if (m_transcriber)
-    {
-        delete m_transcriber;
-        m_transcriber = nullptr;
-    }
 }
 
 void AudioRecorder::setupAudioInput()
@@ -207,7 +223,55 @@ void AudioRecorder::setOpenAIApiKey(const QString &apiKey)
     }
 }
 
-void AudioRecorder::startTranscription()
+void AudioRecorder::setRealtimeWarmSessionEnabled(bool enabled)
+{
+    if (m_transcriber)
+    {
+        m_transcriber->setWarmSessionEnabled(enabled);
+    }
+}
+
+void AudioRecorder::setRealtimeTurnDetection(OpenAITranscriberRealtime::TurnDetection mode)
+{
+    if (m_transcriber)
+    {
+        m_transcriber->setTurnDetection(mode);
+    }
+}
+
+void AudioRecorder::setRealtimeLiveTyping(bool enabled)
+{
+    if (m_transcriber)
+    {
+        m_transcriber->setLiveTypingEnabled(enabled);
+    }
+}
+
+void AudioRecorder::setRealtimeKeepRecording(bool enabled)
+{
+    if (m_transcriber)
+    {
+        m_transcriber->setKeepRecordedAudio(enabled);
+    }
+}
+
+void AudioRecorder::setRealtimeFrameMs(int ms)
+{
+    if (m_transcriber)
+    {
+        m_transcriber->setFrameMs(ms);
+    }
+}
+
+void AudioRecorder::setNetworkQualityEstimator(NetworkQualityEstimator *estimator)
+{
+    if (m_transcriber)
+    {
+        m_transcriber->setNetworkQualityEstimator(estimator);
+    }
+}
+
+void AudioRecorder::startTranscription(quint64 utteranceId)
 {
     if (m_transcriber)
     {
@@ -218,7 +282,7 @@ void AudioRecorder::startTranscription()
         }
 
         // Then start transcription
-        m_transcriber->startStreaming();
+        m_transcriber->startStreaming(utteranceId);
     }
 }
 
@@ -226,14 +290,14 @@ void AudioRecorder::stopTranscription()
 {
     if (m_transcriber)
     {
-        // Stop transcription first
-        m_transcriber->stopStreaming();
-
-        // Then stop audio recording
+        // Stop audio recording first so the final words are in the buffer
         if (m_isRecording)
         {
             stopRecording();
         }
+
+        // Then flush, commit the turn and stop transcription
+        m_transcriber->stopStreaming();
     }
 }
 
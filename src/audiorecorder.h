@@ -9,6 +9,7 @@
 #include <QByteArray>
 #include <QTimer>
 #include <QIODevice>
+#include <QThread>
 #include "audiobuffer.h"
 #include "openaitranscriber_realtime.h"
 
@@ -31,7 +32,13 @@ public:
 
     // OpenAI transcription methods
     void setOpenAIApiKey(const QString &apiKey);
-    void startTranscription();
+    void setRealtimeWarmSessionEnabled(bool enabled);
+    void setRealtimeTurnDetection(OpenAITranscriberRealtime::TurnDetection mode);
+    void setRealtimeLiveTyping(bool enabled);
+    void setRealtimeKeepRecording(bool enabled);
+    void setRealtimeFrameMs(int ms);
+    void setNetworkQualityEstimator(NetworkQualityEstimator *estimator);
+    void startTranscription(quint64 utteranceId = 0);
     void stopTranscription();
     bool isTranscribing() const;
     AudioBuffer *getAudioBuffer() const;
@@ -50,7 +57,12 @@ signals:
     void recordingStopped();
     void recordingError(const QString &error);
     void transcriptionReceived(const QString &text);
+    void transcriptionDelta(const QString &text);
+    void transcriptionRevised(const QString &typed, const QString &text);
     void transcriptionError(const QString &error);
+    void realtimeLagChanged(int ms);
+    void realtimeFallbackAudio(const QByteArray &audio);
+    void realtimeUtteranceTranscribed(quint64 utteranceId, const QString &text, bool complete);
 
 private:
     QAudioInput *m_audioInput;
@@ -59,6 +71,7 @@ private:
     QByteArray m_recordedAudio;
     bool m_isRecording;
     OpenAITranscriberRealtime *m_transcriber;
+    QThread *m_realtimeThread;
     QAudioDevice m_currentDevice;
 
     void setupAudioInput();
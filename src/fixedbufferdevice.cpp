@@ -1,5 +1,12 @@
 #include "fixedbufferdevice.h"
 #include <QDebug>
+#include <cstring>
+
+namespace
+{
+    // Stays well inside the int sizes of the buffer interface
+    const qint64 kMaxBufferSize = 1024 * 1024 * 1024;
+}
 
 FixedBufferDevice::FixedBufferDevice(int bufferSize, QObject *parent)
     : AudioBuffer(parent), m_writePosition(0)
@@ -38,6 +45,17 @@ QByteArray FixedBufferDevice::readAndClear()
     return data;
 }
 
+QByteArray FixedBufferDevice::readFrom(qint64 offset) const
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 availableBytes = qMin(m_totalBytesWritten, static_cast<qint64>(m_bufferSize));
+    if (offset >= availableBytes)
+    {
+        return QByteArray();
+    }
+    return m_buffer.mid(offset, availableBytes - offset);
+}
+
 void FixedBufferDevice::clear()
 {
     QMutexLocker locker(&m_mutex);
@@ -81,8 +99,11 @@ qint64 FixedBufferDevice::writeData(const char *data, qint64 maxSize)
     if (maxSize <= 0)
         return 0;
 
-    QByteArray writeData(data, maxSize);
-    writeToBuffer(writeData);
+    writeToBuffer(data, maxSize);
+    locker.unlock();
+
+    // Let streaming consumers pick up new audio as soon as it arrives
+    emit readyRead();
 
     return maxSize;
 }
@@ -125,54 +146,38 @@ void FixedBufferDevice::resizeBuffer(int newSize)
     m_totalBytesWritten = 0;
 }
 
-void FixedBufferDevice::writeToBuffer(const QByteArray &data)
+void FixedBufferDevice::writeToBuffer(const char *data, qint64 dataSize)
 {
-    int dataSize = data.size();
-    if (dataSize == 0)
+    if (dataSize <= 0)
         return;
 
     // qDebug() << "Writing to buffer at position:" << m_writePosition << "Size:" << dataSize;
 
-    // Check if this write would cause overflow
+    // Grow to fit; doubling keeps the number of copies logarithmic
     if (m_totalBytesWritten + dataSize > m_bufferSize)
     {
-        qDebug() << "FixedBufferDevice: Buffer overflow detected! Doubling buffer size from" << m_bufferSize << "to" << (m_bufferSize * 2);
-
-        // Double the buffer size
-        int oldBufferSize = m_bufferSize;
-        m_bufferSize *= 2;
-
-        // Preserve existing data by reading it first
-        QByteArray existingData = readFromBuffer();
-
-        // Resize buffer to new size
-        resizeBuffer(m_bufferSize);
-        // Restore existing data
-        if (!existingData.isEmpty())
+        const qint64 needed = m_totalBytesWritten + dataSize;
+        if (needed > kMaxBufferSize)
         {
-            m_buffer = existingData;
-            m_writePosition = existingData.size();
-            m_totalBytesWritten = existingData.size();
+            qWarning() << "FixedBufferDevice: Buffer limit of" << kMaxBufferSize << "bytes reached, dropping" << dataSize << "bytes";
+            return;
         }
 
-        // If data is larger than the new buffer size, only keep the first part
-        if (dataSize > m_bufferSize)
+        qint64 newSize = qMax<qint64>(m_bufferSize, 1);
+        while (newSize < needed)
         {
-            QByteArray firstPart = data.left(m_bufferSize);
-            m_buffer = firstPart;
-            m_writePosition = 0;
-            m_totalBytesWritten = m_bufferSize;
-            return;
+            newSize = qMin(newSize * 2, kMaxBufferSize);
         }
-    }
 
-    // Write data to buffer
-    for (int i = 0; i < dataSize; ++i)
-    {
-        m_buffer[m_writePosition] = data[i];
-        m_writePosition = (m_writePosition + 1) % m_bufferSize;
+        qDebug() << "FixedBufferDevice: Buffer overflow detected! Growing buffer size from" << m_bufferSize << "to" << newSize;
+
+        // resize() keeps the existing data
+        m_buffer.resize(newSize);
+        m_bufferSize = static_cast<int>(newSize);
     }
 
+    memcpy(m_buffer.data() + m_writePosition, data, dataSize);
+    m_writePosition += dataSize;
     m_totalBytesWritten += dataSize;
 }
 
@@ -184,16 +189,9 @@ QByteArray FixedBufferDevice::readFromBuffer() const
     }
 
     int availableBytes = qMin(m_totalBytesWritten, static_cast<qint64>(m_bufferSize));
-    QByteArray result;
-    result.reserve(availableBytes);
 
     // Read from beginning of buffer
-    for (int i = 0; i < availableBytes; ++i)
-    {
-        result.append(m_buffer[i]);
-    }
-
-    return result;
+    return m_buffer.left(availableBytes);
 }
 
 void FixedBufferDevice::clearBuffer()
@@ -21,6 +21,9 @@ public:
     // Read current buffer and clear it
     QByteArray readAndClear() override;
 
+    // Read data written since an offset without clearing
+    QByteArray readFrom(qint64 offset) const override;
+
     // Clear the buffer
     void clear() override;
 
@@ -41,7 +44,7 @@ private:
     int m_writePosition;
 
     void resizeBuffer(int newSize) override;
-    void writeToBuffer(const QByteArray &data);
+    void writeToBuffer(const char *data, qint64 dataSize);
     QByteArray readFromBuffer() const;
     void clearBuffer(); // Shared clearing logic
 };
@@ -2,15 +2,89 @@
 #include <QDebug>
 #include <QProcess>
 #include <QThread>
+#include <QGuiApplication>
+#include <QClipboard>
+#include <QMimeData>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QElapsedTimer>
 #include "openaitranscriber_realtime.h"
 
+namespace
+{
+    // Time the target application gets to fetch the pasted text before the
+    // previous clipboard contents are put back
+    const int kPasteSettleMs = 400;
+
+    // How often a wait on the GUI thread checks for cancellation
+    const int kGuiWaitSliceMs = 20;
+
+    // Clipboard contents saved for the duration of one paste
+    struct PasteState
+    {
+        QMimeData *savedClipboard = nullptr;
+        QMimeData *savedSelection = nullptr;
+        QAtomicInt abandoned;
+    };
+
+    QMimeData *copyMimeData(const QMimeData *source)
+    {
+        QMimeData *copy = new QMimeData();
+        if (source)
+        {
+            const QStringList formats = source->formats();
+            for (const QString &format : formats)
+            {
+                copy->setData(format, source->data(format));
+            }
+        }
+        return copy;
+    }
+
+    // The clipboard may only be used from the GUI thread. The call is queued
+    // rather than blocking, because the GUI thread itself waits for the
+    // typing thread on quit; the wait ends early once cancelled() is true,
+    // so the function must only capture by value.
+    template <typename Function>
+    bool runOnGuiThread(Function function, const std::function<bool()> &cancelled)
+    {
+        if (QThread::currentThread() == qApp->thread())
+        {
+            function();
+            return true;
+        }
+
+        QSharedPointer<QSemaphore> done(new QSemaphore());
+        QMetaObject::invokeMethod(qApp, [function, done]()
+                                  {
+            function();
+            done->release(); }, Qt::QueuedConnection);
+
+        while (!done->tryAcquire(1, kGuiWaitSliceMs))
+        {
+            if (cancelled())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
 KeyboardSimulator::KeyboardSimulator()
-    : m_available(false)
+    : m_available(false), m_doesNeedSpace(false)
 {
+    // xdotool is only needed where XTest is missing, e.g. without an X server
+    if (m_xtest.isAvailable())
+    {
+        m_available = true;
+        return;
+    }
+
     m_available = checkXdotoolAvailable();
     if (!m_available)
     {
-        qWarning() << "xdotool not available - keyboard simulation will be disabled";
+        qWarning() << "Neither XTest nor xdotool available - keyboard simulation will be disabled";
     }
 }
 
@@ -44,17 +118,169 @@ bool KeyboardSimulator::typeText(const QString &text)
         return false;
     }
 
-    // Use xdotool to type the text
-    QProcess process;
-    QStringList arguments;
+    if (!inject(0, m_doesNeedSpace ? " " + text : text))
+    {
+        return false;
+    }
+
+    m_doesNeedSpace = text.endsWith(".") || text.endsWith("!") || text.endsWith("?");
+
+    qDebug() << "Successfully typed text:" << text;
+    return true;
+}
 
-    if (m_doesNeedSpace)
+bool KeyboardSimulator::appendText(const QString &text)
+{
+    if (!m_available)
+    {
+        qWarning() << "Keyboard simulator not available";
+        return false;
+    }
+
+    // Continuation of text already typed, so no separating space
+    if (!inject(0, text))
+    {
+        return false;
+    }
+
+    m_doesNeedSpace = text.endsWith(".") || text.endsWith("!") || text.endsWith("?");
+    return true;
+}
+
+bool KeyboardSimulator::replaceText(const QString &oldText, const QString &newText)
+{
+    if (!m_available)
     {
-        arguments << "key" << "space";
+        qWarning() << "Keyboard simulator not available";
+        return false;
     }
 
-    arguments << "type" << text;
+    // Keep the common prefix and only erase and retype the part that changed
+    qsizetype prefix = 0;
+    const qsizetype limit = qMin(oldText.size(), newText.size());
+    while (prefix < limit && oldText.at(prefix) == newText.at(prefix))
+    {
+        ++prefix;
+    }
+
+    // Never split a surrogate pair
+    if (prefix > 0 && oldText.at(prefix - 1).isHighSurrogate())
+    {
+        --prefix;
+    }
+
+    // One backspace per code point
+    const qsizetype eraseCount = oldText.mid(prefix).toUcs4().size();
+    const QString suffix = newText.mid(prefix);
 
+    if (eraseCount == 0 && suffix.isEmpty())
+    {
+        return true;
+    }
+
+    if (!inject(eraseCount, suffix))
+    {
+        return false;
+    }
+
+    m_doesNeedSpace = newText.endsWith(".") || newText.endsWith("!") || newText.endsWith("?");
+
+    qDebug() << "Replaced" << eraseCount << "characters with:" << suffix;
+    return true;
+}
+
+bool KeyboardSimulator::pasteText(const QString &text, bool continuation, const std::function<bool()> &cancelled, qint64 *handoffMs)
+{
+    if (!m_available)
+    {
+        qWarning() << "Keyboard simulator not available";
+        return false;
+    }
+
+    const QString pasted = !continuation && m_doesNeedSpace ? " " + text : text;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Both selections carry the text, so the paste chord works whichever one
+    // the target application reads. A handoff that runs after the wait was
+    // abandoned leaves the clipboard alone.
+    QSharedPointer<PasteState> state(new PasteState());
+    const bool handedOff = runOnGuiThread([state, pasted]()
+                                          {
+        if (state->abandoned.loadAcquire())
+        {
+            return;
+        }
+        QClipboard *clipboard = QGuiApplication::clipboard();
+        state->savedClipboard = copyMimeData(clipboard->mimeData(QClipboard::Clipboard));
+        clipboard->setText(pasted, QClipboard::Clipboard);
+        if (clipboard->supportsSelection())
+        {
+            state->savedSelection = copyMimeData(clipboard->mimeData(QClipboard::Selection));
+            clipboard->setText(pasted, QClipboard::Selection);
+        } }, cancelled);
+    if (!handedOff)
+    {
+        state->abandoned.storeRelease(1);
+        qDebug() << "Paste cancelled before the clipboard was set";
+        return false;
+    }
+
+    bool ok = !cancelled() && (m_xtest.isAvailable() ? m_xtest.sendPasteChord() : runXdotool(QStringList() << "key" << "shift+Insert"));
+    *handoffMs = timer.elapsed();
+
+    // The settle time is cut short on cancellation; the restore below is
+    // then queued without waiting for it
+    QElapsedTimer settle;
+    settle.start();
+    while (ok && settle.elapsed() < kPasteSettleMs && !cancelled())
+    {
+        QThread::msleep(kGuiWaitSliceMs);
+    }
+
+    runOnGuiThread([state]()
+                   {
+        QClipboard *clipboard = QGuiApplication::clipboard();
+        clipboard->setMimeData(state->savedClipboard, QClipboard::Clipboard);
+        if (state->savedSelection)
+        {
+            clipboard->setMimeData(state->savedSelection, QClipboard::Selection);
+        } }, cancelled);
+
+    if (!ok)
+    {
+        return false;
+    }
+
+    m_doesNeedSpace = text.endsWith(".") || text.endsWith("!") || text.endsWith("?");
+    return true;
+}
+
+bool KeyboardSimulator::inject(qsizetype eraseCount, const QString &text)
+{
+    if (m_xtest.isAvailable())
+    {
+        return (eraseCount == 0 || m_xtest.eraseCharacters(eraseCount)) &&
+               (text.isEmpty() || m_xtest.typeText(text));
+    }
+
+    QStringList arguments;
+    if (eraseCount > 0)
+    {
+        arguments << "key" << "--repeat" << QString::number(eraseCount) << "BackSpace";
+    }
+    if (!text.isEmpty())
+    {
+        arguments << "type" << text;
+    }
+
+    return arguments.isEmpty() || runXdotool(arguments);
+}
+
+bool KeyboardSimulator::runXdotool(const QStringList &arguments)
+{
+    QProcess process;
     process.start("xdotool", arguments);
     bool success = process.waitForFinished(5000); // 5 second timeout
 
@@ -71,8 +297,5 @@ bool KeyboardSimulator::typeText(const QString &text)
         return false;
     }
 
-    m_doesNeedSpace = text.endsWith(".") || text.endsWith("!") || text.endsWith("?");
-
-    qDebug() << "Successfully typed text using xdotool:" << text;
     return true;
 }
\ No newline at end of file
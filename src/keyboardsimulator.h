@@ -4,6 +4,8 @@
 #include <QString>
 #include <QProcess>
 #include <QObject>
+#include <functional>
+#include "xtestkeyboard.h"
 
 class KeyboardSimulator : public QObject
 {
@@ -14,13 +16,21 @@ public:
     ~KeyboardSimulator();
 
     bool typeText(const QString &text);
+    bool appendText(const QString &text);
+    bool replaceText(const QString &oldText, const QString &newText);
+    // Gives up waiting on the GUI thread once cancelled() returns true;
+    // handoffMs receives the time to take the clipboard and send the chord
+    bool pasteText(const QString &text, bool continuation, const std::function<bool()> &cancelled, qint64 *handoffMs);
     bool isAvailable() const;
     void onStreamingStarted();
 
 private:
     bool m_available;
     bool m_doesNeedSpace;
+    XTestKeyboard m_xtest;
     bool checkXdotoolAvailable();
+    bool inject(qsizetype eraseCount, const QString &text);
+    bool runXdotool(const QStringList &arguments);
 };
 
 #endif // KEYBOARDSIMULATOR_H
\ No newline at end of file
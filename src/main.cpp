@@ -2,8 +2,14 @@
 #include <QMessageBox>
 #include "mainwindow.h"
 
+#include <X11/Xlib.h>
+
 int main(int argc, char *argv[])
 {
+    // Push-to-talk and typing use their own display connections from
+    // worker threads; this has to come before any other Xlib call
+    XInitThreads();
+
     QApplication app(argc, argv);
     app.setQuitOnLastWindowClosed(false); // Keep app running when window is closed
 
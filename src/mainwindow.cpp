@@ -11,8 +11,25 @@
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), m_globalHotkeyManager(new GlobalHotkeyManager(this)), m_audioRecorder(new AudioRecorder(this)),
-      m_keyboardSimulator(new KeyboardSimulator()), m_openAITranscriber(new OpenAITranscriber(this))
+      m_openAITranscriber(new OpenAITranscriber()), m_transcriberThread(new QThread(this)),
+      m_networkEstimator(new NetworkQualityEstimator(this)), m_typingQueue(new TypingQueue()), m_typingThread(new QThread(this))
 {
+    // Uploads, TLS and reply parsing stay off the GUI thread
+    m_transcriberThread->setObjectName("TranscriberThread");
+    m_openAITranscriber->moveToThread(m_transcriberThread);
+    connect(m_transcriberThread, &QThread::finished, m_openAITranscriber, &QObject::deleteLater);
+    m_transcriberThread->start();
+
+    // Long transcripts are typed without blocking the UI, capture or uploads
+    m_typingThread->setObjectName("TypingThread");
+    m_typingQueue->moveToThread(m_typingThread);
+    connect(m_typingThread, &QThread::finished, m_typingQueue, &QObject::deleteLater);
+    m_typingThread->start();
+
+    // Both engines report what they measure about the link
+    m_openAITranscriber->setNetworkQualityEstimator(m_networkEstimator);
+    m_audioRecorder->setNetworkQualityEstimator(m_networkEstimator);
+
     setupUI();
     setupConnections();
     loadSettings();
@@ -20,7 +37,7 @@ MainWindow::MainWindow(QWidget *parent)
 
     setWindowTitle("Pineapple Writer");
 
-    setFixedSize(500, 450);
+    setFixedSize(500, 520);
     setWindowFlags(Qt::Window | Qt::WindowCloseButtonHint | Qt::WindowMinimizeButtonHint);
     setWindowIcon(QIcon(":/appicon.png"));
 }
@@ -28,6 +45,14 @@ MainWindow::MainWindow(QWidget *parent)
 MainWindow::~MainWindow()
 {
     saveSettings();
+
+    m_transcriberThread->quit();
+    m_transcriberThread->wait();
+
+    // Cancelling first also ends a paste that is waiting on this thread
+    m_typingQueue->cancel();
+    m_typingThread->quit();
+    m_typingThread->wait();
 }
 
 void MainWindow::showUniversalError(const QString &title, const QString &message)
@@ -54,6 +79,7 @@ void MainWindow::showEvent(QShowEvent *event)
         updateTrayIcon();
     }
 
+    updateCacheStats();
     QMainWindow::showEvent(event);
 }
 
@@ -74,6 +100,7 @@ void MainWindow::setupUI()
     setupSetupTab();
     setupAudioTab();
     setupAdvancedTab();
+    setupPerformanceTab();
 }
 
 void MainWindow::setupSetupTab()
@@ -235,8 +262,17 @@ void MainWindow::setupAdvancedTab()
     modelComboBox->addItem("gpt-4o-mini-transcribe");
     modelComboBox->addItem("whisper-1");
 
+    fallbackModelLabel = new QLabel("Fallback Model (used after repeated failures):", modelGroupBox);
+    fallbackModelComboBox = new QComboBox(modelGroupBox);
+    fallbackModelComboBox->addItem("None", QString());
+    fallbackModelComboBox->addItem("gpt-4o-transcribe", "gpt-4o-transcribe");
+    fallbackModelComboBox->addItem("gpt-4o-mini-transcribe", "gpt-4o-mini-transcribe");
+    fallbackModelComboBox->addItem("whisper-1", "whisper-1");
+
     modelLayout->addWidget(modelLabel);
     modelLayout->addWidget(modelComboBox);
+    modelLayout->addWidget(fallbackModelLabel);
+    modelLayout->addWidget(fallbackModelComboBox);
 
     // System Prompt
     systemPromptGroupBox = new QGroupBox("System Prompt", advancedTab);
@@ -259,6 +295,67 @@ void MainWindow::setupAdvancedTab()
     tabWidget->addTab(advancedTab, "Advanced");
 }
 
+void MainWindow::setupPerformanceTab()
+{
+    performanceTab = new QWidget();
+    performanceTabLayout = new QVBoxLayout(performanceTab);
+    performanceTabLayout->setSpacing(20);
+    performanceTabLayout->setContentsMargins(20, 20, 20, 20);
+
+    // Transcription options
+    performanceGroupBox = new QGroupBox("Transcription", performanceTab);
+    performanceLayout = new QVBoxLayout(performanceGroupBox);
+
+    engineLabel = new QLabel("Engine:", performanceGroupBox);
+    engineComboBox = new QComboBox(performanceGroupBox);
+    engineComboBox->addItem("Batch upload after recording", BatchEngine);
+    engineComboBox->addItem("Realtime streaming while recording", RealtimeEngine);
+    engineComboBox->addItem("Hybrid: race both, type the first result", HybridEngine);
+    engineComboBox->addItem("Automatic: choose from measured network quality", AutoEngine);
+
+    chunkedTranscriptionCheckBox = new QCheckBox("Split long recordings into parallel chunks", performanceGroupBox);
+
+    hedgedRequestsCheckBox = new QCheckBox("Send a backup request when the server is slow", performanceGroupBox);
+    twoTierCheckBox = new QCheckBox("Type a fast draft (gpt-4o-mini-transcribe), then correct it", performanceGroupBox);
+    streamedTranscriptionCheckBox = new QCheckBox("Type text while the transcript is still being generated", performanceGroupBox);
+
+    performanceLayout->addWidget(engineLabel);
+    performanceLayout->addWidget(engineComboBox);
+    performanceLayout->addWidget(chunkedTranscriptionCheckBox);
+    performanceLayout->addWidget(hedgedRequestsCheckBox);
+    performanceLayout->addWidget(twoTierCheckBox);
+    performanceLayout->addWidget(streamedTranscriptionCheckBox);
+
+    // Result cache
+    cacheGroupBox = new QGroupBox("Cache", performanceTab);
+    cacheLayout = new QVBoxLayout(cacheGroupBox);
+
+    cacheCheckBox = new QCheckBox("Reuse transcripts of identical recordings", cacheGroupBox);
+    diskCacheCheckBox = new QCheckBox("Keep cached transcripts on disk between sessions", cacheGroupBox);
+    cacheStatsLabel = new QLabel(cacheGroupBox);
+
+    cacheLayout->addWidget(cacheCheckBox);
+    cacheLayout->addWidget(diskCacheCheckBox);
+    cacheLayout->addWidget(cacheStatsLabel);
+
+    // Text injection
+    typingGroupBox = new QGroupBox("Typing", performanceTab);
+    typingLayout = new QVBoxLayout(typingGroupBox);
+
+    pasteCheckBox = new QCheckBox("Paste long transcripts through the clipboard", typingGroupBox);
+
+    typingLayout->addWidget(pasteCheckBox);
+
+    // Add widgets to performance layout
+    performanceTabLayout->addWidget(performanceGroupBox);
+    performanceTabLayout->addWidget(cacheGroupBox);
+    performanceTabLayout->addWidget(typingGroupBox);
+    performanceTabLayout->addStretch();
+
+    // Add performance tab to tab widget
+    tabWidget->addTab(performanceTab, "Performance");
+}
+
 void MainWindow::setupConnections()
 {
     connect(apiKeyEdit, &QLineEdit::textChanged, this, &MainWindow::saveApiKey);
@@ -275,13 +372,37 @@ void MainWindow::setupConnections()
     // Connect transcription signals
     connect(m_audioRecorder, &AudioRecorder::transcriptionReceived,
             this, &MainWindow::onTranscriptionReceived);
+    connect(m_audioRecorder, &AudioRecorder::transcriptionDelta,
+            this, &MainWindow::onTranscriptionDelta);
+    connect(m_audioRecorder, &AudioRecorder::transcriptionRevised,
+            this, &MainWindow::onTranscriptionRevised);
     connect(m_audioRecorder, &AudioRecorder::transcriptionError,
-            this, &MainWindow::onTranscriptionError);
+            this, &MainWindow::onRealtimeTranscriptionError);
+    connect(m_audioRecorder, &AudioRecorder::realtimeUtteranceTranscribed,
+            this, &MainWindow::onRealtimeUtteranceTranscribed);
+    connect(m_audioRecorder, &AudioRecorder::realtimeLagChanged,
+            this, &MainWindow::onRealtimeLagChanged);
+    connect(m_networkEstimator, &NetworkQualityEstimator::policyChanged,
+            this, &MainWindow::updateTrayIcon);
+    connect(m_typingQueue, &TypingQueue::progressChanged,
+            this, &MainWindow::onTypingProgress);
+
+    // A realtime utterance that falls too far behind finishes on the batch path
+    connect(m_audioRecorder, &AudioRecorder::realtimeFallbackAudio,
+            this, &MainWindow::onRealtimeFallbackAudio);
 
     connect(m_openAITranscriber, &OpenAITranscriber::transcriptionReceived,
             this, &MainWindow::onTranscriptionReceived);
+    connect(m_openAITranscriber, &OpenAITranscriber::draftReceived,
+            this, &MainWindow::onTranscriptionReceived);
+    connect(m_openAITranscriber, &OpenAITranscriber::transcriptionDelta,
+            this, &MainWindow::onTranscriptionDelta);
+    connect(m_openAITranscriber, &OpenAITranscriber::transcriptionRevised,
+            this, &MainWindow::onTranscriptionRevised);
     connect(m_openAITranscriber, &OpenAITranscriber::transcriptionError,
             this, &MainWindow::onTranscriptionError);
+    connect(m_openAITranscriber, &OpenAITranscriber::requestFinished,
+            this, &MainWindow::onBatchRequestFinished);
     connect(m_openAITranscriber, &OpenAITranscriber::transcriptionFinished,
             this, &MainWindow::onTranscriptionFinished);
 
@@ -294,7 +415,18 @@ void MainWindow::setupConnections()
     // Connect advanced tab controls
     connect(modelComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &MainWindow::onModelChanged);
+    connect(fallbackModelComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onPerformanceOptionsChanged);
     connect(systemPromptEdit, &QTextEdit::textChanged, this, &MainWindow::onSystemPromptChanged);
+    connect(chunkedTranscriptionCheckBox, &QCheckBox::toggled, this, &MainWindow::onPerformanceOptionsChanged);
+    connect(hedgedRequestsCheckBox, &QCheckBox::toggled, this, &MainWindow::onPerformanceOptionsChanged);
+    connect(twoTierCheckBox, &QCheckBox::toggled, this, &MainWindow::onPerformanceOptionsChanged);
+    connect(streamedTranscriptionCheckBox, &QCheckBox::toggled, this, &MainWindow::onPerformanceOptionsChanged);
+    connect(engineComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onPerformanceOptionsChanged);
+    connect(cacheCheckBox, &QCheckBox::toggled, this, &MainWindow::onPerformanceOptionsChanged);
+    connect(diskCacheCheckBox, &QCheckBox::toggled, this, &MainWindow::onPerformanceOptionsChanged);
+    connect(pasteCheckBox, &QCheckBox::toggled, this, &MainWindow::onPerformanceOptionsChanged);
 
     // Connect the combo box signal to handle device changes
     connect(inputDeviceComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
@@ -303,8 +435,13 @@ void MainWindow::setupConnections()
 
 void MainWindow::onTranscriptionFinished()
 {
-    currentState = IDLE;
+    // A new recording may already be running while the queue drained
+    if (currentState == PROCESSING)
+    {
+        currentState = IDLE;
+    }
     updateTrayIcon();
+    updateCacheStats();
 }
 
 void MainWindow::onPttStateChanged(bool isActive)
@@ -313,7 +450,8 @@ void MainWindow::onPttStateChanged(bool isActive)
 
     if (isActive)
     {
-        if (currentState == IDLE)
+        // Earlier recordings keep uploading in the background
+        if (currentState != RECORDING)
         {
             startRecording();
         }
@@ -366,6 +504,17 @@ void MainWindow::saveSettings()
 
     // Save system prompt
     settings.setValue("systemPrompt", systemPromptEdit->toPlainText());
+
+    // Save performance options
+    settings.setValue("chunkedTranscription", chunkedTranscriptionCheckBox->isChecked());
+    settings.setValue("hedgedRequests", hedgedRequestsCheckBox->isChecked());
+    settings.setValue("twoTierTranscription", twoTierCheckBox->isChecked());
+    settings.setValue("streamedTranscription", streamedTranscriptionCheckBox->isChecked());
+    settings.setValue("fallbackModel", fallbackModelComboBox->currentData().toString());
+    settings.setValue("transcriptionEngine", engineComboBox->currentData().toInt());
+    settings.setValue("transcriptionCache", cacheCheckBox->isChecked());
+    settings.setValue("diskTranscriptionCache", diskCacheCheckBox->isChecked());
+    settings.setValue("pasteLongTranscripts", pasteCheckBox->isChecked());
 }
 
 void MainWindow::loadSettings()
@@ -458,6 +607,26 @@ void MainWindow::loadSettings()
     QString savedSystemPrompt = settings.value("systemPrompt", "").toString();
     systemPromptEdit->setPlainText(savedSystemPrompt);
 
+    // Load performance options
+    chunkedTranscriptionCheckBox->setChecked(settings.value("chunkedTranscription", false).toBool());
+    hedgedRequestsCheckBox->setChecked(settings.value("hedgedRequests", false).toBool());
+    twoTierCheckBox->setChecked(settings.value("twoTierTranscription", false).toBool());
+    streamedTranscriptionCheckBox->setChecked(settings.value("streamedTranscription", false).toBool());
+    int engineIndex = engineComboBox->findData(settings.value("transcriptionEngine", BatchEngine).toInt());
+    engineComboBox->setCurrentIndex(qMax(0, engineIndex));
+    cacheCheckBox->setChecked(settings.value("transcriptionCache", false).toBool());
+    diskCacheCheckBox->setChecked(settings.value("diskTranscriptionCache", false).toBool());
+    pasteCheckBox->setChecked(settings.value("pasteLongTranscripts", false).toBool());
+
+    int fallbackIndex = fallbackModelComboBox->findData(settings.value("fallbackModel", "gpt-4o-mini-transcribe").toString());
+    fallbackModelComboBox->setCurrentIndex(qMax(0, fallbackIndex));
+
+    // Retry policy has no UI; tune it in the settings file
+    m_openAITranscriber->setMaxRetries(settings.value("maxRetries", 4).toInt());
+    m_openAITranscriber->setFailoverAfterFailures(settings.value("failoverAfterFailures", 2).toInt());
+    m_openAITranscriber->setRequestDeadlineMs(settings.value("requestDeadlineMs", 60000).toInt());
+    onPerformanceOptionsChanged();
+
     loadApiKey();
     isLoadingSettings = false;
 }
@@ -492,6 +661,7 @@ void MainWindow::saveApiKey()
 {
     QSettings settings("Pineapple Writer", "Pineapple Writer");
     settings.setValue("apiKey", apiKeyEdit->text());
+    m_audioRecorder->setOpenAIApiKey(apiKeyEdit->text().trimmed());
 }
 
 void MainWindow::loadApiKey()
@@ -559,13 +729,9 @@ void MainWindow::onTranscriptionReceived(const QString &text)
     qDebug() << "Transcription received:" << text;
 
     // Type the received text using keyboard simulation
-    if (m_keyboardSimulator && m_keyboardSimulator->isAvailable())
+    if (m_typingQueue->isAvailable())
     {
-        bool success = m_keyboardSimulator->typeText(text);
-        if (!success)
-        {
-            qWarning() << "Failed to type transcription";
-        }
+        m_typingQueue->typeText(text);
     }
     else
     {
@@ -573,6 +739,30 @@ void MainWindow::onTranscriptionReceived(const QString &text)
     }
 }
 
+void MainWindow::onTranscriptionDelta(const QString &text)
+{
+    if (m_typingQueue->isAvailable())
+    {
+        m_typingQueue->appendText(text);
+    }
+}
+
+void MainWindow::onTranscriptionRevised(const QString &draft, const QString &text)
+{
+    qDebug() << "Transcription revised from draft:" << draft << "to:" << text;
+
+    if (m_typingQueue->isAvailable())
+    {
+        m_typingQueue->replaceText(draft, text);
+    }
+}
+
+void MainWindow::onTypingProgress(int remainingChars)
+{
+    m_typingRemaining = remainingChars;
+    updateTrayIcon();
+}
+
 void MainWindow::onTranscriptionError(const QString &error)
 {
     qWarning() << "Transcription error:" << error;
@@ -594,7 +784,41 @@ void MainWindow::startRecording()
         return;
     }
 
-    m_audioRecorder->startRecording();
+    // A new recording stops whatever is still being typed
+    m_typingQueue->cancel();
+
+    m_recordingEngine = currentEngine();
+    if (m_recordingEngine == AutoEngine)
+    {
+        // Decided per recording from what earlier sessions measured
+        const NetworkQualityEstimator::Policy policy = m_networkEstimator->policy();
+        qDebug() << "Transcription policy:" << policy.describe();
+        m_recordingEngine = policy.realtime ? RealtimeEngine : BatchEngine;
+        m_audioRecorder->setRealtimeFrameMs(policy.frameMs);
+        m_openAITranscriber->setCompactUploadEnabled(policy.compactUpload);
+    }
+
+    if (m_recordingEngine == BatchEngine)
+    {
+        m_audioRecorder->startRecording();
+    }
+    else
+    {
+        // Only a hybrid race needs the whole recording once the stream ends
+        m_audioRecorder->setOpenAIApiKey(apiKey);
+        m_audioRecorder->setRealtimeKeepRecording(m_recordingEngine == HybridEngine);
+
+        quint64 raceId = 0;
+        if (m_recordingEngine == HybridEngine)
+        {
+            // Created now so a stream that fails before release still finds it
+            EngineRace race;
+            race.id = raceId = m_nextRaceId++;
+            race.timer.start();
+            m_races.append(race);
+        }
+        m_audioRecorder->startTranscription(raceId);
+    }
 
     currentState = RECORDING;
     // Update tray icon to show recording
@@ -603,11 +827,30 @@ void MainWindow::startRecording()
 
 void MainWindow::stopRecording()
 {
-    m_audioRecorder->stopRecording();
+    if (m_recordingEngine == BatchEngine)
+    {
+        m_audioRecorder->stopRecording();
 
-    m_openAITranscriber->setApiKey(apiKeyEdit->text().trimmed());
-    m_openAITranscriber->setAudioBuffer(m_audioRecorder->getAudioBuffer());
-    m_openAITranscriber->transcribeAudio();
+        m_openAITranscriber->setApiKey(apiKeyEdit->text().trimmed());
+        m_openAITranscriber->setAudioBuffer(m_audioRecorder->getAudioBuffer());
+        m_openAITranscriber->transcribeAudio();
+    }
+    else
+    {
+        // Stops the microphone, then flushes and commits the stream
+        m_audioRecorder->stopTranscription();
+    }
+
+    if (m_recordingEngine == HybridEngine && !m_races.isEmpty())
+    {
+        // Latency is measured from release
+        EngineRace &race = m_races.last();
+        race.timer.restart();
+
+        // The realtime stream leaves the recording in the buffer for the batch request
+        m_openAITranscriber->setApiKey(apiKeyEdit->text().trimmed());
+        m_openAITranscriber->submitAudio(m_audioRecorder->getAudioBuffer()->getData(), race.id);
+    }
 
     currentState = PROCESSING;
     updateTrayIcon();
@@ -634,10 +877,13 @@ void MainWindow::setupSystemTray()
     // Create tray menu
     m_trayMenu = new QMenu(this);
     m_openAction = m_trayMenu->addAction("Open");
+    m_cancelAction = m_trayMenu->addAction("Cancel Transcription");
     m_quitAction = m_trayMenu->addAction("Quit");
 
     // Connect signals
     connect(m_openAction, &QAction::triggered, this, &MainWindow::show);
+    connect(m_cancelAction, &QAction::triggered, m_openAITranscriber, &OpenAITranscriber::cancelAll);
+    connect(m_cancelAction, &QAction::triggered, m_typingQueue, &TypingQueue::cancel, Qt::DirectConnection);
     connect(m_quitAction, &QAction::triggered, qApp, &QApplication::quit);
     connect(m_trayIcon, &QSystemTrayIcon::activated, [this](QSystemTrayIcon::ActivationReason reason)
             {
@@ -656,21 +902,35 @@ void MainWindow::setupSystemTray()
 
 void MainWindow::updateTrayIcon()
 {
+    QString toolTip;
     if (currentState == RECORDING)
     {
         m_trayIcon->setIcon(QIcon(m_recordingIcon));
-        m_trayIcon->setToolTip("Pineapple Writer - Recording");
+        toolTip = m_realtimeLagMs > 0 ? QString("Pineapple Writer - Recording (network behind by %1 ms)").arg(m_realtimeLagMs)
+                                      : QString("Pineapple Writer - Recording");
     }
     else if (currentState == PROCESSING)
     {
+        int pending = m_openAITranscriber->pendingCount();
         m_trayIcon->setIcon(QIcon(m_processingIcon));
-        m_trayIcon->setToolTip("Pineapple Writer - Processing");
+        toolTip = pending > 1 ? QString("Pineapple Writer - Processing (%1 queued)").arg(pending)
+                              : QString("Pineapple Writer - Processing");
     }
     else
     {
         m_trayIcon->setIcon(QIcon(m_defaultIcon));
-        m_trayIcon->setToolTip("Pineapple Writer");
+        toolTip = "Pineapple Writer";
+    }
+
+    if (m_typingRemaining > 0)
+    {
+        toolTip += QString("\nTyping (%1 characters left)").arg(m_typingRemaining);
+    }
+    if (currentEngine() == AutoEngine)
+    {
+        toolTip += "\n" + m_networkEstimator->policy().describe();
     }
+    m_trayIcon->setToolTip(toolTip);
 }
 
 QPixmap MainWindow::createRecordingIcon(QColor color)
@@ -704,13 +964,17 @@ void MainWindow::onInputMethodChanged()
     updateInputMethodUI();
 
     // Update GlobalHotkeyManager input method
+    // Key release ends a push-to-talk turn, so realtime sessions commit
+    // on the client instead of waiting for server-side silence detection
     if (pttModeRadio->isChecked())
     {
         m_globalHotkeyManager->inputMethod = GlobalHotkeyManager::InputMethod::PTT;
+        m_audioRecorder->setRealtimeTurnDetection(OpenAITranscriberRealtime::TurnDetection::Manual);
     }
     else
     {
         m_globalHotkeyManager->inputMethod = GlobalHotkeyManager::InputMethod::Toggle;
+        m_audioRecorder->setRealtimeTurnDetection(OpenAITranscriberRealtime::TurnDetection::ServerVad);
     }
 }
 
@@ -823,6 +1087,216 @@ void MainWindow::onSystemPromptChanged()
     // qDebug() << "System prompt changed:" << systemPrompt;
 }
 
+void MainWindow::onPerformanceOptionsChanged()
+{
+    TranscriptionEngine engine = currentEngine();
+
+    // A racing batch request must deliver one final result, not drafts or deltas
+    bool hybrid = engine == HybridEngine;
+    twoTierCheckBox->setEnabled(!hybrid);
+    streamedTranscriptionCheckBox->setEnabled(!hybrid);
+
+    m_openAITranscriber->setChunkingEnabled(chunkedTranscriptionCheckBox->isChecked());
+    m_openAITranscriber->setHedgingEnabled(hedgedRequestsCheckBox->isChecked());
+    m_openAITranscriber->setTwoTierEnabled(twoTierCheckBox->isChecked() && !hybrid);
+    m_openAITranscriber->setStreamingEnabled(streamedTranscriptionCheckBox->isChecked() && !hybrid);
+    m_openAITranscriber->setFallbackModel(fallbackModelComboBox->currentData().toString());
+    m_openAITranscriber->setCacheEnabled(cacheCheckBox->isChecked());
+    m_openAITranscriber->setDiskCacheEnabled(cacheCheckBox->isChecked() && diskCacheCheckBox->isChecked());
+
+    // The disk tier only applies on top of the in-memory cache
+    diskCacheCheckBox->setEnabled(cacheCheckBox->isChecked());
+    updateCacheStats();
+
+    m_typingQueue->setPasteEnabled(pasteCheckBox->isChecked());
+
+    // Keep a realtime session warm whenever streaming may be used
+    m_audioRecorder->setOpenAIApiKey(apiKeyEdit->text().trimmed());
+    m_audioRecorder->setRealtimeWarmSessionEnabled(engine != BatchEngine);
+    m_audioRecorder->setRealtimeLiveTyping(engine == RealtimeEngine || engine == AutoEngine);
+
+    // Automatic mode sets these per recording
+    if (engine != AutoEngine)
+    {
+        const NetworkQualityEstimator::Policy defaults;
+        m_audioRecorder->setRealtimeFrameMs(defaults.frameMs);
+        m_openAITranscriber->setCompactUploadEnabled(defaults.compactUpload);
+    }
+    if (m_trayIcon)
+    {
+        updateTrayIcon();
+    }
+
+    saveSettings();
+}
+
+void MainWindow::updateCacheStats()
+{
+    const TranscriptionCache::Stats stats = m_openAITranscriber->cacheStats();
+    QString text = QString("Hits: %1, misses: %2").arg(stats.hits + stats.diskHits).arg(stats.misses);
+    if (diskCacheCheckBox->isChecked() && cacheCheckBox->isChecked())
+    {
+        text += QString(" - %1 transcripts on disk (%2 KB)").arg(stats.diskEntries).arg((stats.diskBytes + 1023) / 1024);
+    }
+    cacheStatsLabel->setText(text);
+}
+
+MainWindow::TranscriptionEngine MainWindow::currentEngine() const
+{
+    return static_cast<TranscriptionEngine>(engineComboBox->currentData().toInt());
+}
+
+void MainWindow::onBatchRequestFinished(quint64 requestId, const QString &text, const QString &error)
+{
+    if (!error.isEmpty())
+    {
+        qWarning() << "Batch transcription failed during hybrid race:" << error;
+    }
+    recordRaceResult(requestId, BatchEngine, text, error.isEmpty() && !text.isEmpty(), error);
+}
+
+void MainWindow::onRealtimeUtteranceTranscribed(quint64 utteranceId, const QString &text, bool complete)
+{
+    if (utteranceId)
+    {
+        recordRaceResult(utteranceId, RealtimeEngine, text, complete && !text.isEmpty());
+        return;
+    }
+
+    // Realtime-only mode has typed the text already
+    if (m_recordingEngine == RealtimeEngine)
+    {
+        onTranscriptionFinished();
+    }
+}
+
+void MainWindow::onRealtimeTranscriptionError(const QString &error)
+{
+    // In hybrid mode the batch request covers for a failed stream; the error
+    // is only shown if that fails too. The stream serves the races it has
+    // not reported on yet.
+    if (m_recordingEngine == HybridEngine)
+    {
+        qWarning() << "Realtime transcription failed during hybrid race:" << error;
+        for (EngineRace &race : m_races)
+        {
+            if (!race.realtimeDone && race.realtimeError.isEmpty())
+            {
+                race.realtimeError = error;
+            }
+        }
+        return;
+    }
+
+    onTranscriptionError(error);
+}
+
+void MainWindow::onRealtimeFallbackAudio(const QByteArray &audio)
+{
+    // A hybrid utterance already has its batch request running
+    if (m_recordingEngine != HybridEngine)
+    {
+        m_openAITranscriber->setApiKey(apiKeyEdit->text().trimmed());
+        m_openAITranscriber->submitAudio(audio);
+    }
+}
+
+void MainWindow::recordRaceResult(quint64 raceId, TranscriptionEngine engine, const QString &text, bool ok, const QString &error)
+{
+    const bool realtime = engine == RealtimeEngine;
+    const char *name = realtime ? "realtime" : "batch";
+
+    qsizetype index = 0;
+    while (index < m_races.size() && m_races.at(index).id != raceId)
+    {
+        ++index;
+    }
+    if (index == m_races.size() || (realtime ? m_races.at(index).realtimeDone : m_races.at(index).batchDone))
+    {
+        qWarning() << "Hybrid race" << raceId << "got an unexpected" << name << "result";
+        return;
+    }
+
+    EngineRace &race = m_races[index];
+    qint64 elapsed = race.timer.elapsed();
+    (realtime ? race.realtimeDone : race.batchDone) = true;
+
+    if (ok)
+    {
+        if (realtime)
+        {
+            m_raceStats.realtimeSamples++;
+            m_raceStats.realtimeTotalMs += elapsed;
+        }
+        else
+        {
+            m_raceStats.batchSamples++;
+            m_raceStats.batchTotalMs += elapsed;
+        }
+
+        if (!race.typed)
+        {
+            race.typed = true;
+            (realtime ? m_raceStats.realtimeWins : m_raceStats.batchWins)++;
+            qDebug() << "Hybrid race won by" << name << "in" << elapsed << "ms";
+            onTranscriptionReceived(text);
+        }
+        else
+        {
+            qDebug() << "Hybrid race:" << name << "finished" << elapsed << "ms after release, result ignored";
+        }
+    }
+    else
+    {
+        qDebug() << "Hybrid race:" << name << "produced no result after" << elapsed << "ms";
+        if (race.fallbackText.isEmpty())
+        {
+            race.fallbackText = text;
+        }
+        if (!realtime)
+        {
+            race.batchError = error;
+        }
+    }
+
+    if (race.realtimeDone && race.batchDone)
+    {
+        // Reported as in single-engine mode, after any partial text
+        const bool failed = !race.typed;
+        QString raceError = !race.batchError.isEmpty() ? race.batchError : race.realtimeError;
+        if (raceError.isEmpty())
+        {
+            raceError = "No transcription text in response";
+        }
+
+        if (failed && !race.fallbackText.isEmpty())
+        {
+            qWarning() << "Neither engine finished cleanly, typing the partial transcript";
+            onTranscriptionReceived(race.fallbackText);
+        }
+        else if (failed)
+        {
+            qWarning() << "Neither realtime nor batch transcription produced text";
+        }
+        m_races.removeAt(index);
+
+        qDebug() << "Hybrid wins - realtime:" << m_raceStats.realtimeWins << "batch:" << m_raceStats.batchWins
+                 << "avg latency ms - realtime:" << (m_raceStats.realtimeSamples ? m_raceStats.realtimeTotalMs / m_raceStats.realtimeSamples : 0)
+                 << "batch:" << (m_raceStats.batchSamples ? m_raceStats.batchTotalMs / m_raceStats.batchSamples : 0);
+
+        if (failed)
+        {
+            onTranscriptionError(raceError);
+        }
+    }
+}
+
+void MainWindow::onRealtimeLagChanged(int ms)
+{
+    m_realtimeLagMs = ms;
+    updateTrayIcon();
+}
+
 void MainWindow::updateInputMethodUI()
 {
     bool isPttMode = pttModeRadio->isChecked();
@@ -23,14 +23,18 @@
 #include <QSlider>
 #include <QProgressBar>
 #include <QTextEdit>
+#include <QCheckBox>
 #include <QAudioDevice>
 #include <QMediaDevices>
 #include <QDebug>
+#include <QThread>
+#include <QElapsedTimer>
 #include "hotkeywidget.h"
 #include "globalhotkeymanager.h"
 #include "audiorecorder.h"
-#include "keyboardsimulator.h"
+#include "typingqueue.h"
 #include "openaitranscriber.h"
+#include "networkqualityestimator.h"
 
 class MainWindow : public QMainWindow
 {
@@ -56,6 +60,8 @@ private slots:
     void onHotkeyChanged(const QString &hotkey);
     void onGlobalHotkeyPressed();
     void onTranscriptionReceived(const QString &text);
+    void onTranscriptionDelta(const QString &text);
+    void onTranscriptionRevised(const QString &draft, const QString &text);
     void onTranscriptionError(const QString &error);
     void onTranscriptionFinished();
     void startRecording();
@@ -69,6 +75,14 @@ private slots:
     void setAudioDevice(const QAudioDevice &device);
     void onModelChanged(int index);
     void onSystemPromptChanged();
+    void onPerformanceOptionsChanged();
+    void updateCacheStats();
+    void onRealtimeLagChanged(int ms);
+    void onTypingProgress(int remainingChars);
+    void onRealtimeUtteranceTranscribed(quint64 utteranceId, const QString &text, bool complete);
+    void onRealtimeTranscriptionError(const QString &error);
+    void onRealtimeFallbackAudio(const QByteArray &audio);
+    void onBatchRequestFinished(quint64 requestId, const QString &text, const QString &error);
 
 private:
     void setupUI();
@@ -78,6 +92,7 @@ private:
     void setupSetupTab();
     void setupAudioTab();
     void setupAdvancedTab();
+    void setupPerformanceTab();
     void populateInputDevices();
 
     enum State
@@ -87,7 +102,49 @@ private:
         PROCESSING
     };
 
+    enum TranscriptionEngine
+    {
+        BatchEngine,
+        RealtimeEngine,
+        HybridEngine,
+        AutoEngine
+    };
+
+    // One utterance in hybrid mode, where realtime and batch race; both
+    // engines report back with the race id exactly once
+    struct EngineRace
+    {
+        quint64 id = 0;
+        QElapsedTimer timer;
+        bool realtimeDone = false;
+        bool batchDone = false;
+        bool typed = false;
+        // Partial text, typed if neither engine finishes cleanly
+        QString fallbackText;
+        // Reported if neither engine finishes cleanly; batch errors win
+        QString batchError;
+        QString realtimeError;
+    };
+
+    struct RaceStats
+    {
+        int realtimeWins = 0;
+        int batchWins = 0;
+        int realtimeSamples = 0;
+        int batchSamples = 0;
+        qint64 realtimeTotalMs = 0;
+        qint64 batchTotalMs = 0;
+    };
+
+    TranscriptionEngine currentEngine() const;
+    void recordRaceResult(quint64 raceId, TranscriptionEngine engine, const QString &text, bool ok, const QString &error = QString());
+
     State currentState = IDLE;
+    TranscriptionEngine m_recordingEngine = BatchEngine;
+    QList<EngineRace> m_races;
+    quint64 m_nextRaceId = 1;
+    RaceStats m_raceStats;
+    int m_realtimeLagMs = 0;
     bool isLoadingSettings = false;
 
     // UI Components
@@ -141,28 +198,57 @@ private:
     QVBoxLayout *modelLayout;
     QLabel *modelLabel;
     QComboBox *modelComboBox;
+    QLabel *fallbackModelLabel;
+    QComboBox *fallbackModelComboBox;
 
     QGroupBox *systemPromptGroupBox;
     QVBoxLayout *systemPromptLayout;
     QLabel *systemPromptLabel;
     QTextEdit *systemPromptEdit;
 
+    // Performance Tab
+    QWidget *performanceTab;
+    QVBoxLayout *performanceTabLayout;
+    QGroupBox *performanceGroupBox;
+    QVBoxLayout *performanceLayout;
+    QLabel *engineLabel;
+    QComboBox *engineComboBox;
+    QCheckBox *chunkedTranscriptionCheckBox;
+    QCheckBox *hedgedRequestsCheckBox;
+    QCheckBox *twoTierCheckBox;
+    QCheckBox *streamedTranscriptionCheckBox;
+
+    QGroupBox *cacheGroupBox;
+    QVBoxLayout *cacheLayout;
+    QCheckBox *cacheCheckBox;
+    QCheckBox *diskCacheCheckBox;
+    QLabel *cacheStatsLabel;
+
+    QGroupBox *typingGroupBox;
+    QVBoxLayout *typingLayout;
+    QCheckBox *pasteCheckBox;
+
     // Global hotkey manager
     GlobalHotkeyManager *m_globalHotkeyManager;
 
     // Audio recorder
     AudioRecorder *m_audioRecorder;
 
-    // OpenAI transcriber
+    // OpenAI transcriber, running on its own network thread
     OpenAITranscriber *m_openAITranscriber;
+    QThread *m_transcriberThread;
+    NetworkQualityEstimator *m_networkEstimator;
 
-    // Keyboard simulator
-    KeyboardSimulator *m_keyboardSimulator;
+    // Keystroke synthesis, running on its own thread
+    TypingQueue *m_typingQueue;
+    QThread *m_typingThread;
+    int m_typingRemaining = 0;
 
     // System tray
-    QSystemTrayIcon *m_trayIcon;
+    QSystemTrayIcon *m_trayIcon = nullptr;
     QMenu *m_trayMenu;
     QAction *m_openAction;
+    QAction *m_cancelAction;
     QAction *m_quitAction;
     QPixmap m_defaultIcon;
     QPixmap m_recordingIcon;
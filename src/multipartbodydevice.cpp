@@ -0,0 +1,80 @@
+#include "multipartbodydevice.h"
+#include <cstring>
+#include <utility>
+
+MultipartBodyDevice::MultipartBodyDevice(QObject *parent)
+    : QIODevice(parent), m_size(0)
+{
+    // Unbuffered so pos() inside readData is the real read position
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+MultipartBodyDevice::~MultipartBodyDevice()
+{
+}
+
+void MultipartBodyDevice::append(const QByteArray &data)
+{
+    append(data, 0, data.size());
+}
+
+void MultipartBodyDevice::append(const QByteArray &data, qsizetype offset, qsizetype length)
+{
+    if (length <= 0)
+    {
+        return;
+    }
+
+    m_segments.append({data, offset, length});
+    m_size += length;
+}
+
+qint64 MultipartBodyDevice::size() const
+{
+    return m_size;
+}
+
+bool MultipartBodyDevice::seek(qint64 pos)
+{
+    if (pos < 0 || pos > m_size)
+    {
+        return false;
+    }
+
+    return QIODevice::seek(pos);
+}
+
+qint64 MultipartBodyDevice::readData(char *data, qint64 maxSize)
+{
+    qint64 position = pos();
+    qint64 bytesRead = 0;
+
+    for (const Segment &segment : std::as_const(m_segments))
+    {
+        if (bytesRead >= maxSize)
+        {
+            break;
+        }
+
+        // Skip segments that lie entirely before the read position
+        if (position >= segment.length)
+        {
+            position -= segment.length;
+            continue;
+        }
+
+        qint64 count = qMin(maxSize - bytesRead, segment.length - position);
+        std::memcpy(data + bytesRead, segment.data.constData() + segment.offset + position, count);
+        bytesRead += count;
+        position = 0;
+    }
+
+    return bytesRead;
+}
+
+qint64 MultipartBodyDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
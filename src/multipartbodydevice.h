@@ -0,0 +1,42 @@
+#ifndef MULTIPARTBODYDEVICE_H
+#define MULTIPARTBODYDEVICE_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QList>
+
+// Read-only device that streams a list of byte ranges back to back. The
+// ranges share their QByteArray storage, so large payloads are never copied
+// before the network stack reads them.
+class MultipartBodyDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit MultipartBodyDevice(QObject *parent = nullptr);
+    ~MultipartBodyDevice();
+
+    void append(const QByteArray &data);
+    void append(const QByteArray &data, qsizetype offset, qsizetype length);
+
+    bool isSequential() const override { return false; }
+    qint64 size() const override;
+    bool seek(qint64 pos) override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    struct Segment
+    {
+        QByteArray data;
+        qsizetype offset;
+        qsizetype length;
+    };
+
+    QList<Segment> m_segments;
+    qint64 m_size;
+};
+
+#endif // MULTIPARTBODYDEVICE_H
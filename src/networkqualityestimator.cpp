@@ -0,0 +1,237 @@
+#include "networkqualityestimator.h"
+#include <QDebug>
+#include <cmath>
+
+namespace
+{
+    // Weight of a new sample in the moving averages
+    const double kSmoothing = 0.25;
+
+    // Realtime audio is 48 kB/s of PCM, 64 kB/s once base64 encoded
+    const double kRealtimeBytesPerSec = 64000.0;
+
+    // Short uploads mostly measure latency, not bandwidth
+    const qint64 kMinThroughputBytes = 64 * 1024;
+    const qint64 kMinThroughputMs = 250;
+
+    const double kPoorFailureRate = 0.3;
+    const double kPoorRttMs = 600.0;
+    const double kPoorHandshakeMs = 3000.0;
+
+    const double kGoodFailureRate = 0.1;
+    const double kGoodRttMs = 200.0;
+    const double kGoodHandshakeMs = 1000.0;
+
+    // Older samples no longer describe the link; failures fade out sooner
+    const qint64 kMaxSampleAgeMs = 3 * 60 * 1000;
+    const double kFailureHalfLifeMs = 60 * 1000.0;
+}
+
+QString NetworkQualityEstimator::Policy::describe() const
+{
+    QString engine = realtime ? QString("realtime, %1 ms frames").arg(frameMs)
+                              : QString(compactUpload ? "batch, 16 kHz upload" : "batch");
+    return QString("%1 network: %2").arg(qualityName(quality), engine);
+}
+
+NetworkQualityEstimator::NetworkQualityEstimator(QObject *parent)
+    : QObject(parent), m_quality(Quality::Unknown), m_rttAt(0), m_handshakeAt(0), m_throughputAt(0), m_outcomeAt(0)
+{
+    m_clock.start();
+}
+
+void NetworkQualityEstimator::recordRtt(qint64 ms)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (isStale(m_rttAt))
+        {
+            m_snapshot.rttMs = -1;
+        }
+        smooth(&m_snapshot.rttMs, ms);
+        m_rttAt = m_clock.elapsed();
+    }
+    update();
+}
+
+void NetworkQualityEstimator::recordHandshake(qint64 ms)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (isStale(m_handshakeAt))
+        {
+            m_snapshot.handshakeMs = -1;
+        }
+        smooth(&m_snapshot.handshakeMs, ms);
+        m_handshakeAt = m_clock.elapsed();
+    }
+    update();
+}
+
+void NetworkQualityEstimator::recordThroughput(qint64 bytes, qint64 ms)
+{
+    if (bytes < kMinThroughputBytes || ms < kMinThroughputMs)
+    {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (isStale(m_throughputAt))
+        {
+            m_snapshot.throughputBytesPerSec = -1;
+        }
+        smooth(&m_snapshot.throughputBytesPerSec, bytes * 1000.0 / ms);
+        m_throughputAt = m_clock.elapsed();
+    }
+    update();
+}
+
+void NetworkQualityEstimator::recordOutcome(bool ok)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        const Snapshot aged = current();
+        m_snapshot.failureRate = aged.failureRate + kSmoothing * ((ok ? 0.0 : 1.0) - aged.failureRate);
+        m_snapshot.outcomes = aged.outcomes + 1;
+        m_outcomeAt = m_clock.elapsed();
+    }
+    update();
+}
+
+NetworkQualityEstimator::Snapshot NetworkQualityEstimator::snapshot() const
+{
+    QMutexLocker locker(&m_mutex);
+    return current();
+}
+
+NetworkQualityEstimator::Quality NetworkQualityEstimator::quality() const
+{
+    // Classified on demand, so expired samples count even without new ones
+    QMutexLocker locker(&m_mutex);
+    return classify(current());
+}
+
+NetworkQualityEstimator::Policy NetworkQualityEstimator::policy() const
+{
+    Policy policy;
+    policy.quality = quality();
+
+    switch (policy.quality)
+    {
+    case Quality::Fair:
+        // Fewer, larger messages ride out jitter better
+        policy.frameMs = 100;
+        break;
+    case Quality::Poor:
+        // Streaming cannot keep up; upload once, as small as possible
+        policy.realtime = false;
+        policy.compactUpload = true;
+        break;
+    case Quality::Good:
+    case Quality::Unknown:
+        break;
+    }
+
+    return policy;
+}
+
+QString NetworkQualityEstimator::qualityName(Quality quality)
+{
+    switch (quality)
+    {
+    case Quality::Good:
+        return "good";
+    case Quality::Fair:
+        return "fair";
+    case Quality::Poor:
+        return "poor";
+    case Quality::Unknown:
+        break;
+    }
+    return "unmeasured";
+}
+
+void NetworkQualityEstimator::update()
+{
+    Snapshot snapshot;
+    Quality quality;
+    {
+        QMutexLocker locker(&m_mutex);
+        snapshot = current();
+        quality = classify(snapshot);
+        if (quality == m_quality)
+        {
+            return;
+        }
+        m_quality = quality;
+    }
+
+    qDebug() << "Network quality is now" << qualityName(quality)
+             << "- rtt ms:" << snapshot.rttMs << "handshake ms:" << snapshot.handshakeMs
+             << "throughput B/s:" << snapshot.throughputBytesPerSec << "failure rate:" << snapshot.failureRate;
+    emit policyChanged();
+}
+
+NetworkQualityEstimator::Snapshot NetworkQualityEstimator::current() const
+{
+    Snapshot snapshot = m_snapshot;
+    if (isStale(m_rttAt))
+    {
+        snapshot.rttMs = -1;
+    }
+    if (isStale(m_handshakeAt))
+    {
+        snapshot.handshakeMs = -1;
+    }
+    if (isStale(m_throughputAt))
+    {
+        snapshot.throughputBytesPerSec = -1;
+    }
+
+    if (isStale(m_outcomeAt))
+    {
+        snapshot.failureRate = 0;
+        snapshot.outcomes = 0;
+    }
+    else
+    {
+        snapshot.failureRate *= std::pow(0.5, (m_clock.elapsed() - m_outcomeAt) / kFailureHalfLifeMs);
+    }
+
+    return snapshot;
+}
+
+bool NetworkQualityEstimator::isStale(qint64 sampledAt) const
+{
+    return m_clock.elapsed() - sampledAt > kMaxSampleAgeMs;
+}
+
+void NetworkQualityEstimator::smooth(double *average, double sample)
+{
+    *average = *average < 0 ? sample : *average + kSmoothing * (sample - *average);
+}
+
+NetworkQualityEstimator::Quality NetworkQualityEstimator::classify(const Snapshot &snapshot)
+{
+    if (snapshot.rttMs < 0 && snapshot.handshakeMs < 0 && snapshot.throughputBytesPerSec < 0 && snapshot.outcomes == 0)
+    {
+        return Quality::Unknown;
+    }
+
+    // Any one symptom of a bad link is enough to stop streaming
+    if (snapshot.failureRate >= kPoorFailureRate || snapshot.rttMs >= kPoorRttMs || snapshot.handshakeMs >= kPoorHandshakeMs ||
+        (snapshot.throughputBytesPerSec >= 0 && snapshot.throughputBytesPerSec < 1.5 * kRealtimeBytesPerSec))
+    {
+        return Quality::Poor;
+    }
+
+    // Metrics without samples yet do not count against the link
+    if (snapshot.failureRate < kGoodFailureRate && snapshot.rttMs < kGoodRttMs && snapshot.handshakeMs < kGoodHandshakeMs &&
+        (snapshot.throughputBytesPerSec < 0 || snapshot.throughputBytesPerSec >= 3 * kRealtimeBytesPerSec))
+    {
+        return Quality::Good;
+    }
+
+    return Quality::Fair;
+}
@@ -0,0 +1,84 @@
+#ifndef NETWORKQUALITYESTIMATOR_H
+#define NETWORKQUALITYESTIMATOR_H
+
+#include <QObject>
+#include <QMutex>
+#include <QString>
+#include <QElapsedTimer>
+
+// Smoothed view of the link to the API, fed by both transcribers: WebSocket
+// round trips, connection handshakes, upload throughput and failed attempts.
+// It recommends how the next recording should be transcribed. Samples expire
+// after a few minutes, so an old verdict does not outlive the conditions
+// that caused it. The record methods may be called from any thread.
+class NetworkQualityEstimator : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Quality
+    {
+        Unknown,
+        Good,
+        Fair,
+        Poor
+    };
+
+    // How to transcribe the next recording
+    struct Policy
+    {
+        Quality quality = Quality::Unknown;
+        bool realtime = true;
+        int frameMs = 40;
+        bool compactUpload = false;
+
+        QString describe() const;
+    };
+
+    // Exponential moving averages; -1 without a recent sample
+    struct Snapshot
+    {
+        double rttMs = -1;
+        double handshakeMs = -1;
+        double throughputBytesPerSec = -1;
+        double failureRate = 0;
+        int outcomes = 0;
+    };
+
+    explicit NetworkQualityEstimator(QObject *parent = nullptr);
+
+    void recordRtt(qint64 ms);
+    void recordHandshake(qint64 ms);
+    void recordThroughput(qint64 bytes, qint64 ms);
+    void recordOutcome(bool ok);
+
+    Snapshot snapshot() const;
+    Quality quality() const;
+    Policy policy() const;
+
+    static QString qualityName(Quality quality);
+
+signals:
+    // The recommended policy changed, e.g. after the link got worse
+    void policyChanged();
+
+private:
+    mutable QMutex m_mutex;
+    Snapshot m_snapshot;
+    Quality m_quality;
+
+    // When each metric was last sampled
+    QElapsedTimer m_clock;
+    qint64 m_rttAt;
+    qint64 m_handshakeAt;
+    qint64 m_throughputAt;
+    qint64 m_outcomeAt;
+
+    void update();
+    Snapshot current() const;
+    bool isStale(qint64 sampledAt) const;
+    static void smooth(double *average, double sample);
+    static Quality classify(const Snapshot &snapshot);
+};
+
+#endif // NETWORKQUALITYESTIMATOR_H
@@ -1,62 +1,260 @@
 #include "openaitranscriber.h"
 #include "audiobuffer.h"
+#include "multipartbodydevice.h"
+#include "networkqualityestimator.h"
 #include <QDebug>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QNetworkRequest>
 #include <QUrl>
-#include <QHttpMultiPart>
-#include <QHttpPart>
-#include <QBuffer>
 #include <QRandomGenerator>
 #include <QCryptographicHash>
+#include <QTimer>
+#include <QDateTime>
+#include <QtEndian>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+    // Latency samples kept for the dynamic hedge threshold
+    const int kLatencyWindow = 50;
+    const int kMinLatencySamples = 10;
+    const int kDefaultHedgeThresholdMs = 4000;
+
+    // Hedging re-uploads the chunk, so skip it for long audio (30 s of 24 kHz PCM16)
+    const qsizetype kHedgeMaxAudioBytes = 30 * 24000 * 2;
+
+    // Exponential backoff between retries, before jitter
+    const qint64 kBaseBackoffMs = 500;
+    const qint64 kMaxBackoffMs = 8000;
+
+    // Upload time allowed on top of the deadline, as for a 256 kbit/s uplink
+    const qint64 kSlowUplinkBytesPerSec = 32 * 1024;
+
+    // Progress up to here only fills local socket buffers, so it says
+    // nothing about the link
+    const qint64 kSendBufferAllowance = 256 * 1024;
+
+    // Compact uploads trade the band above 8 kHz for a third fewer bytes
+    const int kCompactSampleRate = 16000;
+
+    // Resamples 24 kHz PCM16 to 16 kHz: a [1 2 1] low-pass against aliasing,
+    // then two output samples for every three input samples
+    QByteArray resampleForUpload(const QByteArray &pcm)
+    {
+        const qsizetype inCount = pcm.size() / 2;
+        const qsizetype outCount = inCount * 2 / 3;
+        const uchar *in = reinterpret_cast<const uchar *>(pcm.constData());
+
+        auto sample = [in, inCount](qsizetype i)
+        {
+            return static_cast<int>(qFromLittleEndian<qint16>(in + 2 * qBound<qsizetype>(0, i, inCount - 1)));
+        };
+        auto filtered = [&sample](qsizetype i)
+        {
+            return (sample(i - 1) + 2 * sample(i) + sample(i + 1)) / 4;
+        };
+
+        QByteArray out(outCount * 2, Qt::Uninitialized);
+        uchar *dst = reinterpret_cast<uchar *>(out.data());
+        for (qsizetype n = 0; n < outCount; ++n)
+        {
+            // Output sample n sits at input position 1.5 n
+            const qsizetype base = n / 2 * 3;
+            const int value = n % 2 == 0 ? filtered(base) : (filtered(base + 1) + filtered(base + 2)) / 2;
+            qToLittleEndian<qint16>(static_cast<qint16>(value), dst + 2 * n);
+        }
+        return out;
+    }
+}
 
 OpenAITranscriber::OpenAITranscriber(QObject *parent)
-    : QObject(parent), m_networkManager(nullptr), m_currentReply(nullptr), m_audioBuffer(nullptr), m_isTranscribing(false)
+    : QObject(parent), m_networkManager(nullptr), m_hedgeNetworkManager(nullptr), m_nextSessionId(1), m_maxConcurrentSessions(3), m_pendingSubmissions(0), m_audioBuffer(nullptr), m_compactChunker(kCompactSampleRate), m_chunkingEnabled(false), m_hedgingEnabled(false),
+      m_maxRetries(4), m_failoverAfterFailures(2), m_requestDeadlineMs(60000), m_twoTierEnabled(false), m_draftModel("gpt-4o-mini-transcribe"),
+      m_streamingEnabled(false), m_cacheEnabled(false), m_compactUploadEnabled(false), m_networkEstimator(nullptr)
 {
     m_networkManager = new QNetworkAccessManager(this);
+
+    // Separate manager so a hedge opens its own connection instead of queueing behind the slow one
+    m_hedgeNetworkManager = new QNetworkAccessManager(this);
     m_model = "gpt-4o-transcribe";
 }
 
 OpenAITranscriber::~OpenAITranscriber()
 {
-    if (m_currentReply)
+    const QList<QNetworkReply *> replies = m_requests.keys();
+    m_requests.clear();
+    for (QNetworkReply *reply : replies)
     {
-        m_currentReply->abort();
-        m_currentReply->deleteLater();
+        reply->abort();
+        reply->deleteLater();
     }
 }
 
+// Setters may be called from any thread; the worker reads under the same mutex
 void OpenAITranscriber::setSystemPrompt(const QString &systemPrompt)
 {
+    QMutexLocker locker(&m_mutex);
     m_systemPrompt = systemPrompt;
 }
 
 void OpenAITranscriber::setApiKey(const QString &apiKey)
 {
+    QMutexLocker locker(&m_mutex);
     m_apiKey = apiKey;
 }
 
 void OpenAITranscriber::setAudioBuffer(AudioBuffer *buffer)
 {
+    QMutexLocker locker(&m_mutex);
     m_audioBuffer = buffer;
 }
 
 void OpenAITranscriber::setModel(const QString &model)
 {
+    QMutexLocker locker(&m_mutex);
     m_model = model;
 }
 
-void OpenAITranscriber::transcribeAudio()
+void OpenAITranscriber::setChunkingEnabled(bool enabled)
 {
     QMutexLocker locker(&m_mutex);
+    m_chunkingEnabled = enabled;
+}
 
-    if (m_isTranscribing)
+void OpenAITranscriber::setMaxConcurrentSessions(int count)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxConcurrentSessions = qMax(1, count);
+}
+
+int OpenAITranscriber::pendingCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_sessions.size() + m_pendingSubmissions;
+}
+
+void OpenAITranscriber::setHedgingEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_hedgingEnabled = enabled;
+}
+
+OpenAITranscriber::HedgeStats OpenAITranscriber::hedgeStats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hedgeStats;
+}
+
+void OpenAITranscriber::setFallbackModel(const QString &model)
+{
+    QMutexLocker locker(&m_mutex);
+    m_fallbackModel = model;
+}
+
+void OpenAITranscriber::setMaxRetries(int retries)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxRetries = qMax(0, retries);
+}
+
+void OpenAITranscriber::setFailoverAfterFailures(int failures)
+{
+    QMutexLocker locker(&m_mutex);
+    m_failoverAfterFailures = qMax(1, failures);
+}
+
+void OpenAITranscriber::setRequestDeadlineMs(int deadlineMs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_requestDeadlineMs = deadlineMs;
+}
+
+void OpenAITranscriber::setTwoTierEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_twoTierEnabled = enabled;
+}
+
+void OpenAITranscriber::setDraftModel(const QString &model)
+{
+    QMutexLocker locker(&m_mutex);
+    m_draftModel = model;
+}
+
+void OpenAITranscriber::setStreamingEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_streamingEnabled = enabled;
+}
+
+void OpenAITranscriber::setCacheEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cacheEnabled = enabled;
+}
+
+void OpenAITranscriber::setDiskCacheEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.setDiskCacheEnabled(enabled);
+}
+
+TranscriptionCache::Stats OpenAITranscriber::cacheStats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.stats();
+}
+
+void OpenAITranscriber::setCompactUploadEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_compactUploadEnabled = enabled;
+}
+
+void OpenAITranscriber::setNetworkQualityEstimator(NetworkQualityEstimator *estimator)
+{
+    QMutexLocker locker(&m_mutex);
+    m_networkEstimator = estimator;
+}
+
+void OpenAITranscriber::cancelAll()
+{
+    QMutexLocker locker(&m_mutex);
+
+    const QList<QNetworkReply *> replies = m_requests.keys();
+    m_requests.clear();
+    for (QNetworkReply *reply : replies)
+    {
+        reply->abort();
+        reply->deleteLater();
+    }
+
+    if (m_sessions.isEmpty())
     {
-        qDebug() << "Already transcribing, ignoring request";
         return;
     }
 
+    // Pending retries find their session gone and drop out
+    qDebug() << "Cancelled" << m_sessions.size() << "transcription requests";
+    const QList<Session> sessions = m_sessions.values();
+    m_sessions.clear();
+    for (const Session &session : sessions)
+    {
+        if (session.requestId)
+        {
+            emit requestFinished(session.requestId, QString(), "Transcription cancelled");
+        }
+    }
+    emit transcriptionFinished();
+}
+
+void OpenAITranscriber::transcribeAudio()
+{
+    QMutexLocker locker(&m_mutex);
+
     if (m_apiKey.isEmpty())
     {
         emit transcriptionError("API key not set");
@@ -77,117 +275,844 @@ void OpenAITranscriber::transcribeAudio()
         return;
     }
 
-    m_isTranscribing = true;
+    submitAudio(audioData);
+}
+
+void OpenAITranscriber::submitAudio(const QByteArray &audioData, quint64 requestId)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_pendingSubmissions;
+
+    // All network work happens on the thread this object lives on
+    QMetaObject::invokeMethod(this, [this, audioData, requestId]()
+                              { enqueueSession(audioData, requestId); }, Qt::QueuedConnection);
+}
+
+void OpenAITranscriber::enqueueSession(const QByteArray &audioData, quint64 requestId)
+{
+    QMutexLocker locker(&m_mutex);
+    --m_pendingSubmissions;
+
+    // Queue the recording; earlier sessions may still be uploading
+    Session session;
+    session.id = m_nextSessionId++;
+    session.requestId = requestId;
+    session.audio = audioData;
+    session.model = m_model;
+    session.prompt = m_systemPrompt;
+    // A tagged request has a single result, so no draft or streamed text
+    session.twoTier = m_twoTierEnabled && !m_draftModel.isEmpty() && m_draftModel != m_model && !requestId;
+    session.draftModel = m_draftModel;
+    session.streaming = m_streamingEnabled && !session.twoTier && !requestId;
+    if (m_compactUploadEnabled)
+    {
+        session.sampleRate = kCompactSampleRate;
+    }
+
+    // Identical audio with the same model, prompt and upload rate resolves without a request
+    if (m_cacheEnabled)
+    {
+        session.audioDigest = TranscriptionCache::audioDigest(audioData);
+
+        QString cached;
+        if (m_cache.lookup(TranscriptionCache::key(session.audioDigest, session.model, session.prompt, session.sampleRate), &cached))
+        {
+            session.started = true;
+            session.finished = true;
+            session.audio.clear();
+            session.chunkResults = QStringList{cached};
+        }
+        else if (session.twoTier && m_cache.lookup(TranscriptionCache::key(session.audioDigest, session.draftModel, session.prompt, session.sampleRate), &cached))
+        {
+            // The draft is known already; only the full model still has to run
+            session.twoTier = false;
+            session.draftText = cached;
+            session.draftReady = true;
+        }
+
+        TranscriptionCache::Stats stats = m_cache.stats();
+        qDebug() << "Transcription cache - hits:" << stats.hits << "disk hits:" << stats.diskHits << "misses:" << stats.misses;
+    }
+
+    if (session.sampleRate == kCompactSampleRate && !session.finished)
+    {
+        session.audio = resampleForUpload(session.audio);
+    }
+
+    m_sessions.insert(session.id, session);
+
     emit transcriptionStarted();
+    deliverFinishedSessions();
+    startPendingSessions();
+}
+
+void OpenAITranscriber::startPendingSessions()
+{
+    int active = 0;
+    for (const Session &session : std::as_const(m_sessions))
+    {
+        if (session.started && !session.finished)
+        {
+            ++active;
+        }
+    }
 
-    // Create multipart form data
-    QHttpMultiPart *multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+    for (auto it = m_sessions.begin(); it != m_sessions.end() && active < m_maxConcurrentSessions; ++it)
+    {
+        if (!it->started)
+        {
+            startSession(*it);
+            ++active;
+        }
+    }
+}
 
-    // Add the audio file part
-    QHttpPart audioPart;
-    audioPart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("audio/wav"));
-    audioPart.setHeader(QNetworkRequest::ContentDispositionHeader, QVariant("form-data; name=\"file\"; filename=\"audio.wav\""));
+void OpenAITranscriber::startSession(Session &session)
+{
+    // Long recordings are split at silence and the chunks are sent concurrently;
+    // the network manager spreads them over its pooled connections to the host
+    QList<AudioChunker::Chunk> chunks;
+    if (m_chunkingEnabled)
+    {
+        const AudioChunker &chunker = session.sampleRate == kCompactSampleRate ? m_compactChunker : m_chunker;
+        chunks = chunker.split(session.audio);
+    }
+    else
+    {
+        chunks.append({0, session.audio.size()});
+    }
+
+    // Streamed text can only be typed early when there is a single chunk
+    if (chunks.size() > 1)
+    {
+        session.streaming = false;
+    }
+
+    // Waiting behind earlier sessions does not use up the deadline, and
+    // longer recordings get time to upload
+    session.started = true;
+    session.age.start();
+    session.deadlineMs = m_requestDeadlineMs + session.audio.size() * 1000 / kSlowUplinkBytesPerSec;
+    session.chunkResults.resize(chunks.size());
+    session.chunkFailures.fill(0, chunks.size());
+    session.chunksRemaining = chunks.size();
+
+    for (int i = 0; i < chunks.size(); ++i)
+    {
+        startAttempt(session, i, chunks.at(i), AttemptKind::Primary);
+    }
+
+    // The draft model runs on the same audio concurrently
+    if (session.twoTier)
+    {
+        session.draftResults.resize(chunks.size());
+        session.draftRemaining = chunks.size();
+        for (int i = 0; i < chunks.size(); ++i)
+        {
+            startAttempt(session, i, chunks.at(i), AttemptKind::Draft);
+        }
+    }
+
+    qDebug() << "Sending transcription request" << session.id << "to OpenAI API with model:" << session.model
+             << "file size:" << session.audio.size() << "chunks:" << chunks.size();
+}
+
+void OpenAITranscriber::startAttempt(const Session &session, int chunkIndex, const AudioChunker::Chunk &chunk, AttemptKind kind)
+{
+    // Fail over to the fallback model once this chunk has failed often enough
+    QString model = session.model;
+    if (kind == AttemptKind::Draft)
+    {
+        model = session.draftModel;
+    }
+    else if (!m_fallbackModel.isEmpty() && session.chunkFailures.value(chunkIndex) >= m_failoverAfterFailures)
+    {
+        model = m_fallbackModel;
+    }
+
+    // whisper-1 does not support streamed responses
+    bool stream = session.streaming && kind != AttemptKind::Draft && model != "whisper-1";
+
+    QNetworkAccessManager *manager = kind == AttemptKind::Hedge ? m_hedgeNetworkManager : m_networkManager;
+    QNetworkReply *reply = sendRequest(manager, session.audio, session.sampleRate, chunk, model, session.prompt, stream);
+
+    RequestInfo info{session.id, chunkIndex, chunk, kind, model, QElapsedTimer(), false};
+    info.stream = stream;
+    info.timer.start();
+    m_requests.insert(reply, info);
+
+    // Abort the attempt when the session runs out of time
+    qint64 remaining = qMax<qint64>(0, session.deadlineMs - session.age.elapsed());
+    QTimer::singleShot(static_cast<int>(remaining), reply, [this, reply]()
+                       { onAttemptDeadline(reply); });
+
+    if (kind == AttemptKind::Draft)
+    {
+        return;
+    }
+
+    if (kind == AttemptKind::Hedge)
+    {
+        ++m_hedgeStats.hedged;
+        return;
+    }
+
+    ++m_hedgeStats.requests;
+
+    if (m_hedgingEnabled && chunk.length <= kHedgeMaxAudioBytes)
+    {
+        // The reply is the timer context, so the hedge is cancelled once it is deleted
+        QTimer::singleShot(hedgeThresholdMs(), reply, [this, reply]()
+                           { onHedgeTimeout(reply); });
+    }
+}
+
+void OpenAITranscriber::onHedgeTimeout(QNetworkReply *primary)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // A streaming reply that already produced text is not slow
+    auto it = m_requests.constFind(primary);
+    if (it == m_requests.constEnd() || findOtherAttempt(*it) || !it->streamText.isEmpty())
+    {
+        return;
+    }
+
+    // Copy before startAttempt inserts into m_requests
+    const RequestInfo info = *it;
+    auto session = m_sessions.constFind(info.sessionId);
+    if (session == m_sessions.constEnd())
+    {
+        return;
+    }
+
+    qDebug() << "No response for request" << info.sessionId << "chunk" << info.chunkIndex << "after"
+             << info.timer.elapsed() << "ms, sending hedged request";
+
+    startAttempt(*session, info.chunkIndex, info.chunk, AttemptKind::Hedge);
+}
+
+void OpenAITranscriber::onAttemptDeadline(QNetworkReply *reply)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_requests.find(reply);
+    if (it == m_requests.end())
+    {
+        return;
+    }
+
+    it->deadlineExceeded = true;
+    reply->abort();
+}
+
+bool OpenAITranscriber::scheduleRetry(Session &session, const RequestInfo &info, qint64 retryAfterMs)
+{
+    int failures = ++session.chunkFailures[info.chunkIndex];
+    if (failures > m_maxRetries)
+    {
+        return false;
+    }
+
+    // Jittered exponential backoff, but never sooner than the server asked for
+    qint64 backoff = qMin(kMaxBackoffMs, kBaseBackoffMs << qMin(failures - 1, 8));
+    qint64 delay = backoff / 2 + QRandomGenerator::global()->bounded(static_cast<int>(backoff / 2) + 1);
+    delay = qMax(delay, retryAfterMs);
+
+    if (session.age.elapsed() + delay >= session.deadlineMs)
+    {
+        return false;
+    }
+
+    qWarning() << "Transcription request" << session.id << "chunk" << info.chunkIndex << "failed, retry" << failures
+               << "of" << m_maxRetries << "in" << delay << "ms";
+
+    quint64 sessionId = session.id;
+    int chunkIndex = info.chunkIndex;
+    AudioChunker::Chunk chunk = info.chunk;
+    QTimer::singleShot(static_cast<int>(delay), this, [this, sessionId, chunkIndex, chunk]()
+                       {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_sessions.constFind(sessionId);
+        if (it != m_sessions.constEnd())
+        {
+            startAttempt(*it, chunkIndex, chunk, AttemptKind::Primary);
+        } });
+
+    return true;
+}
+
+bool OpenAITranscriber::isRetryable(QNetworkReply *reply) const
+{
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 0)
+    {
+        // No HTTP response at all: connection refused, reset, DNS or TLS failure
+        return reply->error() != QNetworkReply::NoError && reply->error() != QNetworkReply::OperationCanceledError;
+    }
+
+    return status == 408 || status == 409 || status == 429 || status >= 500;
+}
 
-    // Create WAV file from PCM data
-    QByteArray wavData = createAudioFile(audioData);
-    audioPart.setBody(wavData);
-    multiPart->append(audioPart);
+qint64 OpenAITranscriber::retryAfterMs(QNetworkReply *reply) const
+{
+    QByteArray value = reply->rawHeader("Retry-After").trimmed();
+    if (value.isEmpty())
+    {
+        return 0;
+    }
+
+    // Either delay-seconds or an HTTP date
+    bool ok = false;
+    int seconds = value.toInt(&ok);
+    if (ok)
+    {
+        return qMax(0, seconds) * 1000LL;
+    }
+
+    QDateTime date = QDateTime::fromString(QString::fromLatin1(value), Qt::RFC2822Date);
+    return date.isValid() ? qMax<qint64>(0, QDateTime::currentDateTimeUtc().msecsTo(date)) : 0;
+}
+
+QNetworkReply *OpenAITranscriber::findOtherAttempt(const RequestInfo &info) const
+{
+    for (auto it = m_requests.constBegin(); it != m_requests.constEnd(); ++it)
+    {
+        if (it->sessionId == info.sessionId && it->chunkIndex == info.chunkIndex && it->kind != info.kind &&
+            it->kind != AttemptKind::Draft && info.kind != AttemptKind::Draft)
+        {
+            return it.key();
+        }
+    }
+    return nullptr;
+}
+
+int OpenAITranscriber::hedgeThresholdMs() const
+{
+    if (m_latencySamples.size() < kMinLatencySamples)
+    {
+        return kDefaultHedgeThresholdMs;
+    }
+
+    // Hedge once a request is slower than the observed p90
+    QList<qint64> sorted = m_latencySamples;
+    std::sort(sorted.begin(), sorted.end());
+    qint64 p90 = sorted.at(sorted.size() * 9 / 10);
+    return static_cast<int>(qBound<qint64>(1000, p90, 15000));
+}
+
+qint64 OpenAITranscriber::estimateLatencySaved(qint64 elapsedMs) const
+{
+    // The aborted request would have taken longer than elapsedMs; estimate how
+    // much longer from the recorded latencies that exceeded it
+    qint64 total = 0;
+    int count = 0;
+    for (qint64 sample : m_latencySamples)
+    {
+        if (sample > elapsedMs)
+        {
+            total += sample;
+            ++count;
+        }
+    }
+
+    return count > 0 ? total / count - elapsedMs : 0;
+}
+
+void OpenAITranscriber::recordLatency(qint64 elapsedMs)
+{
+    m_latencySamples.append(elapsedMs);
+    if (m_latencySamples.size() > kLatencyWindow)
+    {
+        m_latencySamples.removeFirst();
+    }
+}
+
+QNetworkReply *OpenAITranscriber::sendRequest(QNetworkAccessManager *manager, const QByteArray &audioData, int sampleRate, const AudioChunker::Chunk &chunk, const QString &model, const QString &prompt, bool stream)
+{
+    // The body is streamed from shared byte ranges: the PCM samples are read
+    // straight out of the session's buffer instead of being copied into a
+    // WAV file and then again into a multipart body
+    const QByteArray boundary = generateBoundary();
+    MultipartBodyDevice *body = new MultipartBodyDevice();
+
+    // Add the audio file part
+    body->append("--" + boundary + "\r\n"
+                 "Content-Type: audio/wav\r\n"
+                 "Content-Disposition: form-data; name=\"file\"; filename=\"audio.wav\"\r\n\r\n");
+    body->append(createWavHeader(chunk.length, sampleRate));
+    body->append(audioData, chunk.offset, chunk.length);
+    body->append("\r\n");
 
     // Add the model part
-    QHttpPart modelPart;
-    modelPart.setHeader(QNetworkRequest::ContentDispositionHeader, QVariant("form-data; name=\"model\""));
-    modelPart.setBody(m_model.toUtf8());
-    multiPart->append(modelPart);
+    body->append("--" + boundary + "\r\n"
+                 "Content-Disposition: form-data; name=\"model\"\r\n\r\n" +
+                 model.toUtf8() + "\r\n");
 
-    if (!m_systemPrompt.isEmpty())
+    if (!prompt.isEmpty())
     {
-        QHttpPart systemPromptPart;
-        systemPromptPart.setHeader(QNetworkRequest::ContentDispositionHeader, QVariant("form-data; name=\"prompt\""));
-        systemPromptPart.setBody(m_systemPrompt.toUtf8());
-        multiPart->append(systemPromptPart);
+        body->append("--" + boundary + "\r\n"
+                     "Content-Disposition: form-data; name=\"prompt\"\r\n\r\n" +
+                     prompt.toUtf8() + "\r\n");
     }
 
+    if (stream)
+    {
+        body->append("--" + boundary + "\r\n"
+                     "Content-Disposition: form-data; name=\"stream\"\r\n\r\n"
+                     "true\r\n");
+    }
+
+    body->append("--" + boundary + "--\r\n");
+
     // Create the request
     QNetworkRequest request(QUrl("https://api.openai.com/v1/audio/transcriptions"));
     request.setRawHeader("Authorization", QString("Bearer %1").arg(m_apiKey).toUtf8());
+    request.setHeader(QNetworkRequest::ContentTypeHeader, QByteArray("multipart/form-data; boundary=" + boundary));
+    request.setHeader(QNetworkRequest::ContentLengthHeader, body->size());
 
     // Send the request
-    m_currentReply = m_networkManager->post(request, multiPart);
-    multiPart->setParent(m_currentReply); // Delete the multiPart with the reply
+    QNetworkReply *reply = manager->post(request, body);
+    body->setParent(reply); // Delete the body with the reply
 
     // Connect signals
-    connect(m_currentReply, &QNetworkReply::finished, this, &OpenAITranscriber::onNetworkReplyFinished);
-    connect(m_currentReply, &QNetworkReply::errorOccurred,
+    connect(reply, &QNetworkReply::finished, this, &OpenAITranscriber::onNetworkReplyFinished);
+    if (stream)
+    {
+        connect(reply, &QNetworkReply::readyRead, this, &OpenAITranscriber::onNetworkReplyReadyRead);
+    }
+    connect(reply, &QNetworkReply::errorOccurred,
             this, &OpenAITranscriber::onNetworkReplyError);
+    if (m_networkEstimator)
+    {
+        connect(reply, &QNetworkReply::uploadProgress, this, &OpenAITranscriber::onNetworkReplyUploadProgress);
+    }
 
-    qDebug() << "Sending transcription request to OpenAI API with model:" << m_model << "file size:" << audioData.size();
+    return reply;
+}
+
+QByteArray OpenAITranscriber::generateBoundary()
+{
+    return "boundary_" + QByteArray::number(QRandomGenerator::global()->generate64(), 16);
 }
 
 bool OpenAITranscriber::isTranscribing() const
 {
-    return m_isTranscribing;
+    QMutexLocker locker(&m_mutex);
+    return !m_sessions.isEmpty() || m_pendingSubmissions > 0;
 }
 
 void OpenAITranscriber::onNetworkReplyFinished()
 {
     QMutexLocker locker(&m_mutex);
 
-    if (!m_currentReply)
+    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+    if (!reply || !m_requests.contains(reply))
+    {
+        return;
+    }
+
+    RequestInfo info = m_requests.take(reply);
+
+    QString error;
+    QString text;
+    if (info.stream && reply->error() == QNetworkReply::NoError)
+    {
+        // Prefer the server's final transcript over the concatenated deltas
+        readStreamEvents(reply, info);
+        if (!info.streamBuffer.trimmed().isEmpty())
+        {
+            // The last event may not be followed by a blank line
+            info.streamBuffer.append("\n\n");
+            readStreamEvents(reply, info);
+        }
+        text = info.streamFinalText.isNull() ? info.streamText : info.streamFinalText;
+    }
+    else
+    {
+        text = parseReply(reply, &error);
+    }
+
+    // Only transport failures say something about the link, not HTTP errors
+    if (m_networkEstimator)
+    {
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (error.isEmpty())
+        {
+            m_networkEstimator->recordOutcome(true);
+        }
+        else if (info.deadlineExceeded || (status == 0 && reply->error() != QNetworkReply::OperationCanceledError))
+        {
+            m_networkEstimator->recordOutcome(false);
+        }
+    }
+    reply->deleteLater();
+
+    if (info.kind == AttemptKind::Draft)
+    {
+        handleDraftReply(info, text, error);
+        return;
+    }
+
+    QNetworkReply *otherAttempt = findOtherAttempt(info);
+    if (otherAttempt)
+    {
+        if (!error.isEmpty())
+        {
+            // The other attempt for this chunk may still succeed
+            qDebug() << "Attempt for request" << info.sessionId << "chunk" << info.chunkIndex << "failed, waiting for the other:" << error;
+            return;
+        }
+
+        // First success wins; abort the loser
+        RequestInfo loser = m_requests.take(otherAttempt);
+        if (info.kind == AttemptKind::Hedge)
+        {
+            ++m_hedgeStats.hedgeWins;
+            m_hedgeStats.latencySavedMs += estimateLatencySaved(loser.timer.elapsed());
+        }
+        otherAttempt->abort();
+        otherAttempt->deleteLater();
+
+        qDebug() << "Hedge stats - requests:" << m_hedgeStats.requests << "hedged:" << m_hedgeStats.hedged
+                 << "hedge wins:" << m_hedgeStats.hedgeWins << "latency saved:" << m_hedgeStats.latencySavedMs << "ms";
+    }
+
+    if (error.isEmpty())
+    {
+        recordLatency(info.timer.elapsed());
+    }
+
+    auto it = m_sessions.find(info.sessionId);
+    if (it == m_sessions.end())
+    {
+        return;
+    }
+
+    // Transient failures are retried from the audio kept in the session
+    if (!error.isEmpty())
+    {
+        if (info.deadlineExceeded)
+        {
+            error = "Transcription request timed out";
+        }
+        else if (isRetryable(reply) && scheduleRetry(*it, info, retryAfterMs(reply)))
+        {
+            return;
+        }
+    }
+
+    if (error.isEmpty())
+    {
+        it->chunkResults[info.chunkIndex] = text;
+    }
+    else
+    {
+        it->error = error;
+    }
+
+    if (--it->chunksRemaining > 0)
+    {
+        return;
+    }
+
+    it->finished = true;
+    it->audio.clear();
+    abortDraftAttempts(info.sessionId);
+
+    deliverFinishedSessions();
+    startPendingSessions();
+}
+
+void OpenAITranscriber::onNetworkReplyReadyRead()
+{
+    QMutexLocker locker(&m_mutex);
+
+    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+    auto it = m_requests.find(reply);
+    if (!reply || it == m_requests.end())
+    {
+        return;
+    }
+
+    // Error bodies are plain JSON; leave them for parseReply
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() != 200)
+    {
+        return;
+    }
+
+    if (!readStreamEvents(reply, *it))
+    {
+        return;
+    }
+
+    const RequestInfo info = *it;
+
+    // The first attempt to stream text owns the chunk; drop the other one
+    QNetworkReply *otherAttempt = findOtherAttempt(info);
+    if (otherAttempt)
+    {
+        m_requests.remove(otherAttempt);
+        otherAttempt->abort();
+        otherAttempt->deleteLater();
+    }
+
+    auto session = m_sessions.find(info.sessionId);
+    if (session == m_sessions.end() || session->finished)
+    {
+        return;
+    }
+
+    session->streamText = info.streamText;
+    deliverFinishedSessions();
+}
+
+bool OpenAITranscriber::readStreamEvents(QNetworkReply *reply, RequestInfo &info)
+{
+    info.streamBuffer.append(reply->readAll());
+    info.streamBuffer.replace("\r\n", "\n");
+
+    // Events are separated by a blank line; keep an incomplete tail for the next read
+    bool gotDelta = false;
+    qsizetype end;
+    while ((end = info.streamBuffer.indexOf("\n\n")) >= 0)
+    {
+        const QByteArray event = info.streamBuffer.left(end);
+        info.streamBuffer.remove(0, end + 2);
+
+        QByteArray data;
+        for (const QByteArray &line : event.split('\n'))
+        {
+            if (line.startsWith("data:"))
+            {
+                data += line.mid(5).trimmed();
+            }
+        }
+
+        if (data.isEmpty() || data == "[DONE]")
+        {
+            continue;
+        }
+
+        QJsonObject eventObj = QJsonDocument::fromJson(data).object();
+        QString type = eventObj["type"].toString();
+        if (type == "transcript.text.delta")
+        {
+            info.streamText += eventObj["delta"].toString();
+            gotDelta = true;
+        }
+        else if (type == "transcript.text.done")
+        {
+            info.streamFinalText = eventObj["text"].toString();
+        }
+    }
+
+    return gotDelta;
+}
+
+void OpenAITranscriber::handleDraftReply(const RequestInfo &info, const QString &text, const QString &error)
+{
+    auto it = m_sessions.find(info.sessionId);
+    if (it == m_sessions.end() || it->finished)
+    {
+        return;
+    }
+
+    // A failed draft is simply skipped; the full model's result is typed as usual
+    if (error.isEmpty())
+    {
+        it->draftResults[info.chunkIndex] = text;
+    }
+    else
+    {
+        qDebug() << "Draft transcription for request" << info.sessionId << "failed:" << error;
+        it->draftFailed = true;
+    }
+
+    if (--it->draftRemaining > 0)
     {
         return;
     }
 
-    if (m_currentReply->error() == QNetworkReply::NoError)
+    if (!it->draftFailed)
+    {
+        const QStringList &parts = it->draftResults;
+        it->draftText = parts.size() == 1 ? parts.first() : AudioChunker::stitch(parts);
+        it->draftReady = true;
+
+        if (!it->audioDigest.isEmpty() && !it->draftText.isEmpty())
+        {
+            m_cache.insert(TranscriptionCache::key(it->audioDigest, it->draftModel, it->prompt, it->sampleRate), it->draftText);
+        }
+    }
+
+    deliverFinishedSessions();
+}
+
+void OpenAITranscriber::abortDraftAttempts(quint64 sessionId)
+{
+    QList<QNetworkReply *> drafts;
+    for (auto it = m_requests.constBegin(); it != m_requests.constEnd(); ++it)
+    {
+        if (it->sessionId == sessionId && it->kind == AttemptKind::Draft)
+        {
+            drafts.append(it.key());
+        }
+    }
+
+    for (QNetworkReply *reply : drafts)
+    {
+        m_requests.remove(reply);
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+QString OpenAITranscriber::parseReply(QNetworkReply *reply, QString *error)
+{
+    if (reply->error() == QNetworkReply::NoError)
     {
-        QByteArray responseData = m_currentReply->readAll();
+        QByteArray responseData = reply->readAll();
         QJsonParseError parseError;
         QJsonDocument doc = QJsonDocument::fromJson(responseData, &parseError);
 
         if (parseError.error == QJsonParseError::NoError)
         {
             QJsonObject jsonObj = doc.object();
-            QString text = jsonObj["text"].toString();
+            return jsonObj["text"].toString();
+        }
 
-            if (!text.isEmpty())
+        *error = QString("Failed to parse response: %1").arg(parseError.errorString());
+        return QString();
+    }
+
+    QString errorString = reply->errorString();
+    QByteArray errorData = reply->readAll();
+
+    // Try to parse error response for more details
+    QJsonParseError parseError;
+    QJsonDocument errorDoc = QJsonDocument::fromJson(errorData, &parseError);
+    if (parseError.error == QJsonParseError::NoError)
+    {
+        QJsonObject errorObj = errorDoc.object();
+        QString errorMessage = errorObj["error"].toObject()["message"].toString();
+        if (!errorMessage.isEmpty())
+        {
+            errorString = errorMessage;
+        }
+    }
+
+    *error = QString("Network error: %1").arg(errorString);
+    return QString();
+}
+
+void OpenAITranscriber::deliverFinishedSessions()
+{
+    // Results are typed strictly in submission order, so a fast later session
+    // waits for every earlier one to finish first
+    while (!m_sessions.isEmpty())
+    {
+        Session &head = m_sessions.first();
+        if (!head.finished)
+        {
+            // Only the oldest session may type early text, so revising it
+            // never has to erase text typed after it
+            if (head.draftReady && head.typedText.isEmpty() && !head.draftText.isEmpty())
             {
-                emit transcriptionReceived(text);
-                // qDebug() << "Transcription received:" << text;
+                head.typedText = head.draftText;
+                emit draftReceived(head.draftText);
             }
-            else
+            else if (head.streamText.size() > head.typedText.size() && head.streamText.startsWith(head.typedText))
             {
-                emit transcriptionError("No transcription text in response");
+                QString delta = head.streamText.mid(head.typedText.size());
+                bool first = head.typedText.isEmpty();
+                head.typedText = head.streamText;
+                if (first)
+                {
+                    emit transcriptionReceived(delta);
+                }
+                else
+                {
+                    emit transcriptionDelta(delta);
+                }
             }
+            break;
         }
-        else
+
+        Session session = m_sessions.take(m_sessions.firstKey());
+        const QStringList &parts = session.chunkResults;
+        QString text = parts.size() == 1 ? parts.first() : AudioChunker::stitch(parts);
+
+        // Results produced by the fallback model are not cached under the primary model
+        bool failedOver = !m_fallbackModel.isEmpty() &&
+                          std::any_of(session.chunkFailures.cbegin(), session.chunkFailures.cend(),
+                                      [this](int failures)
+                                      { return failures >= m_failoverAfterFailures; });
+        if (!session.audioDigest.isEmpty() && session.error.isEmpty() && !text.isEmpty() && !failedOver)
         {
-            emit transcriptionError(QString("Failed to parse response: %1").arg(parseError.errorString()));
+            m_cache.insert(TranscriptionCache::key(session.audioDigest, session.model, session.prompt, session.sampleRate), text);
         }
-    }
-    else
-    {
-        QString errorString = m_currentReply->errorString();
-        QByteArray errorData = m_currentReply->readAll();
 
-        // Try to parse error response for more details
-        QJsonParseError parseError;
-        QJsonDocument errorDoc = QJsonDocument::fromJson(errorData, &parseError);
-        if (parseError.error == QJsonParseError::NoError)
+        if (session.requestId)
         {
-            QJsonObject errorObj = errorDoc.object();
-            QString errorMessage = errorObj["error"].toObject()["message"].toString();
-            if (!errorMessage.isEmpty())
+            QString error = session.error;
+            if (error.isEmpty() && text.isEmpty())
             {
-                errorString = errorMessage;
+                error = "No transcription text in response";
             }
+            emit requestFinished(session.requestId, text, error);
+            continue;
         }
 
-        emit transcriptionError(QString("Network error: %1").arg(errorString));
+        if (!session.typedText.isEmpty())
+        {
+            if (session.error.isEmpty() && !text.isEmpty())
+            {
+                if (text != session.typedText)
+                {
+                    emit transcriptionRevised(session.typedText, text);
+                }
+            }
+            else
+            {
+                qWarning() << "Keeping early text for request" << session.id << "-" << (session.error.isEmpty() ? QString("empty result") : session.error);
+            }
+            continue;
+        }
+
+        // The full model failed outright but the draft made it
+        if (!session.error.isEmpty() && text.isEmpty() && !session.draftText.isEmpty())
+        {
+            qWarning() << "Using draft for request" << session.id << "-" << session.error;
+            session.error.clear();
+            text = session.draftText;
+        }
+
+        if (!session.error.isEmpty())
+        {
+            // Deliver whatever the successful chunks produced before reporting the failure
+            if (!text.isEmpty())
+            {
+                emit transcriptionReceived(text);
+            }
+            emit transcriptionError(session.error);
+        }
+        else if (!text.isEmpty())
+        {
+            emit transcriptionReceived(text);
+            // qDebug() << "Transcription received:" << text;
+        }
+        else
+        {
+            emit transcriptionError("No transcription text in response");
+        }
     }
 
-    m_currentReply->deleteLater();
-    m_currentReply = nullptr;
-    m_isTranscribing = false;
-    emit transcriptionFinished();
+    // A submission still crossing to the worker thread keeps the pipeline busy
+    if (m_sessions.isEmpty() && m_pendingSubmissions == 0)
+    {
+        emit transcriptionFinished();
+    }
 }
 
 void OpenAITranscriber::onNetworkReplyError(QNetworkReply::NetworkError error)
@@ -196,57 +1121,69 @@ void OpenAITranscriber::onNetworkReplyError(QNetworkReply::NetworkError error)
     // Error handling is done in onNetworkReplyFinished
 }
 
-QByteArray OpenAITranscriber::createAudioFile(const QByteArray &audioData)
+void OpenAITranscriber::onNetworkReplyUploadProgress(qint64 bytesSent, qint64 bytesTotal)
 {
-    // Create a simple WAV file header for PCM data
-    // Assuming 16-bit PCM, 16kHz sample rate, mono channel
-    QByteArray wavData;
+    QMutexLocker locker(&m_mutex);
+
+    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+    auto it = m_requests.find(reply);
+    if (it == m_requests.end() || it->uploaded || bytesTotal <= 0)
+    {
+        return;
+    }
 
-    // WAV file header (44 bytes)
-    const int sampleRate = 16000;
-    const int numChannels = 1;
-    const int bitsPerSample = 16;
-    const int dataSize = audioData.size();
-    const int fileSize = 36 + dataSize;
+    if (it->windowStartBytes < 0)
+    {
+        if (bytesSent >= kSendBufferAllowance && bytesSent < bytesTotal)
+        {
+            it->windowStartBytes = bytesSent;
+            it->windowStartMs = it->timer.elapsed();
+        }
+    }
 
-    // Helper function to convert to little-endian bytes
-    auto toLittleEndian = [](quint32 value) -> QByteArray
+    if (bytesSent < bytesTotal)
     {
-        QByteArray bytes;
-        bytes.append(static_cast<char>(value & 0xFF));
-        bytes.append(static_cast<char>((value >> 8) & 0xFF));
-        bytes.append(static_cast<char>((value >> 16) & 0xFF));
-        bytes.append(static_cast<char>((value >> 24) & 0xFF));
-        return bytes;
-    };
+        return;
+    }
 
-    auto toLittleEndian16 = [](quint16 value) -> QByteArray
+    // With the buffer full, progress advances only as the link drains it.
+    // Uploads that fit in the buffer never open a window and are skipped.
+    it->uploaded = true;
+    if (m_networkEstimator && it->windowStartBytes >= 0)
     {
-        QByteArray bytes;
-        bytes.append(static_cast<char>(value & 0xFF));
-        bytes.append(static_cast<char>((value >> 8) & 0xFF));
-        return bytes;
-    };
+        m_networkEstimator->recordThroughput(bytesTotal - it->windowStartBytes, it->timer.elapsed() - it->windowStartMs);
+    }
+}
+
+QByteArray OpenAITranscriber::createWavHeader(qsizetype dataSize, int sampleRate)
+{
+    // Create a simple WAV file header for 16-bit mono PCM data
+    const quint16 numChannels = 1;
+    const quint16 bitsPerSample = 16;
+    const quint32 fileSize = 36 + static_cast<quint32>(dataSize);
+
+    // WAV file header (44 bytes), written in place
+    QByteArray header(44, Qt::Uninitialized);
+    char *out = header.data();
 
     // RIFF header
-    wavData.append("RIFF", 4);
-    wavData.append(toLittleEndian(fileSize));
-    wavData.append("WAVE", 4);
+    std::memcpy(out, "RIFF", 4);
+    qToLittleEndian<quint32>(fileSize, out + 4);
+    std::memcpy(out + 8, "WAVE", 4);
 
     // fmt chunk
-    wavData.append("fmt ", 4);
-    wavData.append(toLittleEndian(16));  // fmt chunk size
-    wavData.append(toLittleEndian16(1)); // PCM format
-    wavData.append(toLittleEndian16(numChannels));
-    wavData.append(toLittleEndian(sampleRate));
-    wavData.append(toLittleEndian(sampleRate * numChannels * bitsPerSample / 8)); // byte rate
-    wavData.append(toLittleEndian16(numChannels * bitsPerSample / 8));            // block align
-    wavData.append(toLittleEndian16(bitsPerSample));
+    std::memcpy(out + 12, "fmt ", 4);
+    qToLittleEndian<quint32>(16, out + 16); // fmt chunk size
+    qToLittleEndian<quint16>(1, out + 20);  // PCM format
+    qToLittleEndian<quint16>(numChannels, out + 22);
+    qToLittleEndian<quint32>(sampleRate, out + 24);
+    qToLittleEndian<quint32>(sampleRate * numChannels * bitsPerSample / 8, out + 28); // byte rate
+    qToLittleEndian<quint16>(numChannels * bitsPerSample / 8, out + 32);              // block align
+    qToLittleEndian<quint16>(bitsPerSample, out + 34);
 
     // data chunk
-    wavData.append("data", 4);
-    wavData.append(toLittleEndian(dataSize));
-    wavData.append(audioData);
+    std::memcpy(out + 36, "data", 4);
+    qToLittleEndian<quint32>(static_cast<quint32>(dataSize), out + 40);
 
-    return wavData;
-}
\ No newline at end of file
+    return header;
+}
@@ -8,9 +8,19 @@
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QMutex>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QStringList>
+#include "audiochunker.h"
+#include "transcriptioncache.h"
 
 class AudioBuffer;
+class NetworkQualityEstimator;
 
+// Batch transcription through /v1/audio/transcriptions. Meant to live on a
+// worker thread: setters, transcribeAudio() and submitAudio() may be called
+// from any thread and results come back through queued signals.
 class OpenAITranscriber : public QObject
 {
     Q_OBJECT
@@ -23,32 +33,188 @@ public:
     void setAudioBuffer(AudioBuffer *buffer);
     void setModel(const QString &model = "gpt-4o-transcribe");
     void transcribeAudio();
+    // A non-zero requestId reports the result once through requestFinished()
+    // instead of the typing signals
+    void submitAudio(const QByteArray &audioData, quint64 requestId = 0);
     bool isTranscribing() const;
     void setSystemPrompt(const QString &systemPrompt);
+    void setChunkingEnabled(bool enabled);
+    void setMaxConcurrentSessions(int count);
+    int pendingCount() const;
+    void setHedgingEnabled(bool enabled);
+    void setFallbackModel(const QString &model);
+    void setMaxRetries(int retries);
+    void setFailoverAfterFailures(int failures);
+    void setRequestDeadlineMs(int deadlineMs);
+    void setTwoTierEnabled(bool enabled);
+    void setDraftModel(const QString &model);
+    void setStreamingEnabled(bool enabled);
+    void setCacheEnabled(bool enabled);
+    void setDiskCacheEnabled(bool enabled);
+    TranscriptionCache::Stats cacheStats() const;
+    void setCompactUploadEnabled(bool enabled);
+    void setNetworkQualityEstimator(NetworkQualityEstimator *estimator);
+    void cancelAll();
+
+    // Counters for tuning the cost/latency trade-off of hedged requests
+    struct HedgeStats
+    {
+        int requests = 0;
+        int hedged = 0;
+        int hedgeWins = 0;
+        qint64 latencySavedMs = 0;
+    };
+
+    HedgeStats hedgeStats() const;
 
 signals:
     void transcriptionReceived(const QString &text);
+    void transcriptionDelta(const QString &text);
+    void draftReceived(const QString &text);
+    void transcriptionRevised(const QString &draft, const QString &text);
     void transcriptionError(const QString &error);
     void transcriptionStarted();
     void transcriptionFinished();
+    // Exactly one per tagged request; error is empty on success
+    void requestFinished(quint64 requestId, const QString &text, const QString &error);
 
 private slots:
     void onNetworkReplyFinished();
+    void onNetworkReplyReadyRead();
     void onNetworkReplyError(QNetworkReply::NetworkError error);
+    void onNetworkReplyUploadProgress(qint64 bytesSent, qint64 bytesTotal);
 
 private:
+    // One recording submitted by the user; results are delivered in id order
+    struct Session
+    {
+        quint64 id = 0;
+        quint64 requestId = 0;
+        QByteArray audio;
+        int sampleRate = 24000;
+        QByteArray audioDigest;
+        QString model;
+        QString prompt;
+
+        // Runs from the first attempt, not from submission
+        QElapsedTimer age;
+        qint64 deadlineMs = 0;
+        QList<int> chunkFailures;
+        QStringList chunkResults;
+        int chunksRemaining = 0;
+        QString error;
+        bool started = false;
+        bool finished = false;
+
+        // Two-tier mode: the draft model's result is typed first and later revised
+        bool twoTier = false;
+        QString draftModel;
+        QStringList draftResults;
+        int draftRemaining = 0;
+        bool draftFailed = false;
+        bool draftReady = false;
+        QString draftText;
+
+        // Streaming mode: deltas received so far for the single chunk
+        bool streaming = false;
+        QString streamText;
+
+        // Text already handed out for typing (a draft or streamed deltas)
+        QString typedText;
+    };
+
+    enum class AttemptKind
+    {
+        Primary,
+        Hedge,
+        Draft
+    };
+
+    // One HTTP attempt for a chunk; a hedged chunk has two attempts in flight
+    struct RequestInfo
+    {
+        quint64 sessionId;
+        int chunkIndex;
+        AudioChunker::Chunk chunk;
+        AttemptKind kind;
+        QString model;
+        QElapsedTimer timer;
+        bool deadlineExceeded;
+
+        // Server-sent events state for streamed responses
+        bool stream = false;
+        QByteArray streamBuffer;
+        QString streamText;
+        QString streamFinalText;
+
+        // Set once the whole body has been handed to the network
+        bool uploaded = false;
+
+        // Throughput window, opened once the socket send buffer is full
+        qint64 windowStartBytes = -1;
+        qint64 windowStartMs = 0;
+    };
+
     QNetworkAccessManager *m_networkManager;
-    QNetworkReply *m_currentReply;
+    QNetworkAccessManager *m_hedgeNetworkManager;
+    QHash<QNetworkReply *, RequestInfo> m_requests;
+    QMap<quint64, Session> m_sessions;
+    quint64 m_nextSessionId;
+    int m_maxConcurrentSessions;
+    int m_pendingSubmissions;
     AudioBuffer *m_audioBuffer;
     QString m_apiKey;
     QString m_model;
-    bool m_isTranscribing;
-    QMutex m_mutex;
+    mutable QRecursiveMutex m_mutex;
     QString m_systemPrompt;
 
-    QByteArray createMultipartData(const QByteArray &audioData);
-    QString generateBoundary();
-    QByteArray createAudioFile(const QByteArray &audioData);
+    AudioChunker m_chunker;
+    AudioChunker m_compactChunker;
+    bool m_chunkingEnabled;
+
+    bool m_hedgingEnabled;
+    HedgeStats m_hedgeStats;
+    QList<qint64> m_latencySamples;
+
+    // Retry and failover policy
+    QString m_fallbackModel;
+    int m_maxRetries;
+    int m_failoverAfterFailures;
+    int m_requestDeadlineMs;
+
+    bool m_twoTierEnabled;
+    QString m_draftModel;
+
+    bool m_streamingEnabled;
+
+    TranscriptionCache m_cache;
+    bool m_cacheEnabled;
+
+    // Slow links: 16 kHz uploads, and samples for the engine selection
+    bool m_compactUploadEnabled;
+    NetworkQualityEstimator *m_networkEstimator;
+
+    void enqueueSession(const QByteArray &audioData, quint64 requestId);
+    void startPendingSessions();
+    void startSession(Session &session);
+    void startAttempt(const Session &session, int chunkIndex, const AudioChunker::Chunk &chunk, AttemptKind kind);
+    void handleDraftReply(const RequestInfo &info, const QString &text, const QString &error);
+    void abortDraftAttempts(quint64 sessionId);
+    bool readStreamEvents(QNetworkReply *reply, RequestInfo &info);
+    void onHedgeTimeout(QNetworkReply *primary);
+    void onAttemptDeadline(QNetworkReply *reply);
+    bool scheduleRetry(Session &session, const RequestInfo &info, qint64 retryAfterMs);
+    bool isRetryable(QNetworkReply *reply) const;
+    qint64 retryAfterMs(QNetworkReply *reply) const;
+    QNetworkReply *findOtherAttempt(const RequestInfo &info) const;
+    int hedgeThresholdMs() const;
+    qint64 estimateLatencySaved(qint64 elapsedMs) const;
+    void recordLatency(qint64 elapsedMs);
+    void deliverFinishedSessions();
+    QNetworkReply *sendRequest(QNetworkAccessManager *manager, const QByteArray &audioData, int sampleRate, const AudioChunker::Chunk &chunk, const QString &model, const QString &prompt, bool stream);
+    QString parseReply(QNetworkReply *reply, QString *error);
+    QByteArray generateBoundary();
+    QByteArray createWavHeader(qsizetype dataSize, int sampleRate);
 };
 
 #endif // OPENAITRANSCRIBER_H
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "openaitranscriber_realtime.h"
 #include "audiobuffer.h"
+#include "audiochunker.h"
+#include "networkqualityestimator.h"
 #include <QDebug>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -8,246 +10,1520 @@
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QUrlQuery>
+#include <QRegularExpression>
 #include <QTimer>
+#include <utility>
+
+namespace
+{
+    // 24 kHz mono 16-bit PCM
+    const int kBytesPerMs = 24000 * 2 / 1000;
+    const int kMinFrameMs = 20;
+    const int kMaxFrameMs = 200;
+
+    // Sessions are replaced well before the server's 30 minute limit
+    const int kWarmSessionRefreshMs = 25 * 60 * 1000;
+    const int kWarmSessionRetryMs = 5000;
+    const int kMaxWarmSessionRetryMs = 5 * 60 * 1000;
+
+    // Reconnection after an unexpected drop
+    const int kMaxReconnectAttempts = 5;
+    const int kBaseReconnectDelayMs = 250;
+    const int kMaxReconnectDelayMs = 4000;
+    const qsizetype kMaxReplayBytes = 60 * 1000 * kBytesPerMs;
+
+    // The server rejects commits of less than 100 ms of audio
+    const qsizetype kMinCommitBytes = 100 * kBytesPerMs;
+    const int kDrainTimeoutMs = 5000;
+
+    // Past this much unsent audio the utterance moves to the batch path
+    const int kFallbackLagMs = 2500;
+    const int kLagReportStepMs = 100;
+
+    // Streams roll over to a new session ahead of the 30 minute limit, at the
+    // next pause if possible and mid-speech once the limit is close
+    const int kSessionRolloverMs = 27 * 60 * 1000;
+    const int kSessionForceRolloverMs = 29 * 60 * 1000;
+    const qsizetype kRolloverOverlapBytes = 500 * kBytesPerMs;
+    const int kMaxOverlapWords = 8;
+
+    // Link measurements: round trips while streaming, throughput per window
+    const int kPingIntervalMs = 5000;
+    const int kThroughputWindowMs = 1000;
+    const int kWarmPingIntervalMs = 60 * 1000;
+
+    // A failed upgrade reports the HTTP status only in the error string, as
+    // "Unhandled http status code: 401 (Unauthorized)"
+    bool isAuthFailure(const QString &errorString)
+    {
+        static const QRegularExpression status(R"(status code:?\s*(401|403)\b|\b(401|403)\s*\(?(Unauthorized|Forbidden)\b)",
+                                               QRegularExpression::CaseInsensitiveOption);
+        return status.match(errorString).hasMatch();
+    }
+
+    // The error code of a server event that rejects the key itself
+    bool isAuthErrorCode(const QString &code)
+    {
+        return code == "invalid_api_key";
+    }
+
+    // Drops the words at the start of text that repeat the end of previous,
+    // the last transcript of the session being replaced
+    QString removeOverlap(const QString &previous, const QString &text)
+    {
+        const QString head = previous.simplified();
+        const QString stitched = AudioChunker::stitch({head, text}, kMaxOverlapWords);
+        return stitched.mid(head.size()).trimmed();
+    }
+}
 
 OpenAITranscriberRealtime::OpenAITranscriberRealtime(QObject *parent)
-    : QObject(parent), m_webSocket(nullptr), m_workerThread(nullptr), m_timer(nullptr), m_audioBuffer(nullptr), m_isStreaming(false), m_sessionId(""), m_currentItemId("")
+    : QObject(parent), m_webSocket(nullptr), m_audioBuffer(nullptr), m_isStreaming(false), m_sessionId(""), m_currentItemId(""), m_frameMs(40),
+      m_warmSessionEnabled(false), m_warmSocket(nullptr), m_warmReady(false), m_warmRefreshTimer(new QTimer(this)),
+      m_warmRetryDelayMs(kWarmSessionRetryMs), m_warmAuthFailed(false), m_warmPingTimer(new QTimer(this)),
+      m_coldStartPending(false), m_reconnectAttempts(0), m_uncommittedOffset(0), m_speechEndOffset(-1),
+      m_turnDetection(TurnDetection::ServerVad), m_speechActive(false), m_commitPending(false),
+      m_liveTypingEnabled(true), m_utteranceId(0), m_utteranceFailed(false), m_drainingUtteranceId(0), m_keepRecordedAudio(false), m_bufferReadOffset(0),
+      m_drainingSocket(nullptr), m_drainingCommitPending(false),
+      m_rolloverTimer(new QTimer(this)), m_rolloverPending(false), m_retiringSocket(nullptr), m_retiringCommitPending(false), m_overlapPending(false),
+      m_networkEstimator(nullptr), m_pingTimer(new QTimer(this)), m_throughputBytes(0),
+      m_reportedLagMs(0), m_fallbackActive(false), m_catchUpBytes(0)
+{
+    m_warmRefreshTimer->setSingleShot(true);
+    m_warmRefreshTimer->setInterval(kWarmSessionRefreshMs);
+    connect(m_warmRefreshTimer, &QTimer::timeout, this, [this]()
+            {
+        qDebug() << "Refreshing warm realtime session";
+        discardWarmSession();
+        prepareWarmSession(); });
+
+    m_rolloverTimer->setSingleShot(true);
+    connect(m_rolloverTimer, &QTimer::timeout, this, &OpenAITranscriberRealtime::onRolloverTimeout);
+
+    m_pingTimer->setInterval(kPingIntervalMs);
+    connect(m_pingTimer, &QTimer::timeout, this, [this]()
+            {
+        if (m_webSocket && m_webSocket->state() == QAbstractSocket::ConnectedState)
+        {
+            m_webSocket->ping();
+        } });
+
+    m_warmPingTimer->setInterval(kWarmPingIntervalMs);
+    connect(m_warmPingTimer, &QTimer::timeout, this, [this]()
+            {
+        if (m_warmReady && m_warmSocket && m_warmSocket->state() == QAbstractSocket::ConnectedState)
+        {
+            m_warmSocket->ping();
+        } });
+}
+
+OpenAITranscriberRealtime::~OpenAITranscriberRealtime()
+{
+    // Runs on the worker thread once its event loop has finished
+    endStreaming();
+    finishDrain();
+    finishRetiring();
+    discardWarmSession();
+}
+
+void OpenAITranscriberRealtime::setApiKey(const QString &apiKey)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_apiKey == apiKey)
+    {
+        return;
+    }
+    m_apiKey = apiKey;
+    m_warmAuthFailed = false;
+
+    // A warm session opened with the old key is no longer usable
+    QMetaObject::invokeMethod(this, [this]()
+                              {
+        m_warmRetryDelayMs = kWarmSessionRetryMs;
+        discardWarmSession();
+        prepareWarmSession(); }, Qt::QueuedConnection);
+}
+
+void OpenAITranscriberRealtime::setAudioBuffer(AudioBuffer *buffer)
+{
+    if (m_audioBuffer)
+    {
+        disconnect(m_audioBuffer, &QIODevice::readyRead, this, &OpenAITranscriberRealtime::onAudioAvailable);
+    }
+
+    m_audioBuffer = buffer;
+
+    if (m_audioBuffer)
+    {
+        connect(m_audioBuffer, &QIODevice::readyRead, this, &OpenAITranscriberRealtime::onAudioAvailable);
+    }
+}
+
+void OpenAITranscriberRealtime::setFrameMs(int ms)
+{
+    QMutexLocker locker(&m_mutex);
+    m_frameMs = qBound(kMinFrameMs, ms, kMaxFrameMs);
+}
+
+int OpenAITranscriberRealtime::frameMs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_frameMs;
+}
+
+OpenAITranscriberRealtime::FrameStats OpenAITranscriberRealtime::frameStats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_frameStats;
+}
+
+void OpenAITranscriberRealtime::setWarmSessionEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_warmSessionEnabled = enabled;
+
+    QMetaObject::invokeMethod(this, [this, enabled]()
+                              {
+        if (enabled)
+        {
+            prepareWarmSession();
+        }
+        else
+        {
+            discardWarmSession();
+        } }, Qt::QueuedConnection);
+}
+
+OpenAITranscriberRealtime::StartStats OpenAITranscriberRealtime::startStats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_startStats;
+}
+
+void OpenAITranscriberRealtime::setTurnDetection(TurnDetection mode)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_turnDetection == mode)
+    {
+        return;
+    }
+    m_turnDetection = mode;
+
+    // Reconfigure the live session and replace the warm one
+    QMetaObject::invokeMethod(this, [this]()
+                              {
+        if (m_webSocket && !m_sessionId.isEmpty())
+        {
+            sendSessionUpdate(m_webSocket);
+        }
+        discardWarmSession();
+        prepareWarmSession(); }, Qt::QueuedConnection);
+}
+
+void OpenAITranscriberRealtime::commitTurn()
+{
+    QMetaObject::invokeMethod(this, [this]()
+                              {
+        if (!m_isStreaming)
+        {
+            return;
+        }
+        onAudioAvailable();
+        sendPendingFrames(true);
+        sendCommit(true); }, Qt::QueuedConnection);
+}
+
+void OpenAITranscriberRealtime::setLiveTypingEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_liveTypingEnabled = enabled;
+}
+
+void OpenAITranscriberRealtime::setKeepRecordedAudio(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_keepRecordedAudio = enabled;
+}
+
+void OpenAITranscriberRealtime::setNetworkQualityEstimator(NetworkQualityEstimator *estimator)
+{
+    QMetaObject::invokeMethod(this, [this, estimator]()
+                              { m_networkEstimator = estimator; }, Qt::QueuedConnection);
+}
+
+void OpenAITranscriberRealtime::startStreaming(quint64 utteranceId)
+{
+    // The socket, TLS and JSON parsing all run on the thread this object lives on
+    QMetaObject::invokeMethod(this, [this, utteranceId]()
+                              { beginStreaming(utteranceId); }, Qt::QueuedConnection);
+}
+
+void OpenAITranscriberRealtime::stopStreaming()
+{
+    QMetaObject::invokeMethod(this, [this]()
+                              { endStreaming(); }, Qt::QueuedConnection);
+}
+
+bool OpenAITranscriberRealtime::isStreaming() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_isStreaming;
+}
+
+void OpenAITranscriberRealtime::beginStreaming(quint64 utteranceId)
+{
+    // A start that is refused still reports its utterance as failed
+    if (m_isStreaming)
+    {
+        qDebug() << "Already streaming, ignoring start request";
+        emit utteranceTranscribed(utteranceId, QString(), false);
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_apiKey.isEmpty())
+        {
+            locker.unlock();
+            emit transcriptionError("API key not set");
+            emit utteranceTranscribed(utteranceId, QString(), false);
+            return;
+        }
+    }
+
+    if (!m_audioBuffer)
+    {
+        emit transcriptionError("Circular buffer not set");
+        emit utteranceTranscribed(utteranceId, QString(), false);
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_isStreaming = true;
+        m_frameStats = FrameStats();
+    }
+    m_sessionId = "";
+    m_currentItemId = "";
+    m_pendingAudio.clear();
+    m_reconnectAttempts = 0;
+    resetReplayWindow();
+    m_speechActive = false;
+    m_commitPending = false;
+    m_pendingItems.clear();
+    m_reportedLagMs = 0;
+    m_fallbackActive = false;
+    m_fallbackAudio.clear();
+    m_catchUpBytes = 0;
+    if (!m_drainingSocket)
+    {
+        // Items of earlier sessions can no longer complete
+        m_typedText.clear();
+    }
+    m_utteranceId = utteranceId;
+    m_utteranceText.clear();
+    m_utteranceFailed = false;
+    m_bufferReadOffset = 0;
+    m_rolloverPending = false;
+    m_overlapPending = false;
+    m_overlapItemId.clear();
+    m_lastTranscript.clear();
+    m_throughputTimer.invalidate();
+    m_pingTimer->start();
+    m_startTimer.start();
+
+    if (takeWarmSession())
+    {
+        recordStartLatency(true);
+    }
+    else
+    {
+        m_coldStartPending = true;
+        setupWebSocket();
+    }
+
+    emit streamingStarted();
+
+    // Get the next session ready while this one streams
+    prepareWarmSession();
+}
+
+void OpenAITranscriberRealtime::endStreaming()
+{
+    if (!m_isStreaming)
+    {
+        return;
+    }
+
+    // Send whatever is left of the last frame and end the turn right away
+    // instead of waiting for the server to detect silence
+    onAudioAvailable();
+    sendPendingFrames(true);
+    sendCommit(false);
+
+    if (m_fallbackActive)
+    {
+        m_fallbackActive = false;
+        m_utteranceFailed = true;
+        if (!m_fallbackAudio.isEmpty())
+        {
+            emit batchFallbackRequested(m_fallbackAudio);
+        }
+        m_fallbackAudio.clear();
+    }
+
+    if (m_reportedLagMs != 0)
+    {
+        m_reportedLagMs = 0;
+        emit networkLagChanged(0);
+    }
+
+    m_coldStartPending = false;
+    m_reconnectTimer.invalidate();
+    resetReplayWindow();
+
+    m_rolloverTimer->stop();
+    m_rolloverPending = false;
+    m_overlapPending = false;
+    m_overlapItemId.clear();
+    m_pingTimer->stop();
+    if (m_retiringSocket && (m_retiringCommitPending || !m_retiringItems.isEmpty()))
+    {
+        // The text of the previous session's last items would arrive too late
+        m_utteranceFailed = true;
+    }
+    finishRetiring();
+
+    FrameStats stats;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_isStreaming = false;
+        stats = m_frameStats;
+    }
+
+    if (stats.frames > 0)
+    {
+        qDebug() << "Realtime frames sent:" << stats.frames
+                 << "bytes:" << stats.bytesSent
+                 << "avg frame delay ms:" << stats.totalFrameDelayMs / stats.frames
+                 << "max frame delay ms:" << stats.maxFrameDelayMs
+                 << "max queued bytes:" << stats.maxQueuedBytes;
+    }
+
+    if (m_webSocket && m_webSocket->state() == QAbstractSocket::ConnectedState &&
+        (m_commitPending || !m_pendingItems.isEmpty()))
+    {
+        drainSession();
+    }
+    else
+    {
+        if (m_webSocket)
+        {
+            m_webSocket->close();
+            delete m_webSocket;
+            m_webSocket = nullptr;
+        }
+        emit utteranceTranscribed(m_utteranceId, m_utteranceText, !m_utteranceFailed);
+    }
+    m_utteranceId = 0;
+    m_utteranceText.clear();
+
+    emit streamingStopped();
+}
+
+void OpenAITranscriberRealtime::sendCommit(bool force)
 {
-    // Create timer for periodic audio processing
-    m_timer = new QTimer(this);
-    m_timer->setInterval(1000);
-    connect(m_timer, &QTimer::timeout, this, &OpenAITranscriberRealtime::onTimerTimeout);
+    if (!m_webSocket || m_webSocket->state() != QAbstractSocket::ConnectedState || m_sessionId.isEmpty())
+    {
+        return;
+    }
+
+    // With server VAD only an utterance still in progress needs committing;
+    // anything else is trailing silence
+    bool manual;
+    {
+        QMutexLocker locker(&m_mutex);
+        manual = m_turnDetection == TurnDetection::Manual;
+    }
+    if (!force && !manual && !m_speechActive)
+    {
+        return;
+    }
+
+    if (m_uncommittedAudio.size() < kMinCommitBytes)
+    {
+        return;
+    }
+
+    m_webSocket->sendTextMessage(QStringLiteral("{\"type\":\"input_audio_buffer.commit\"}"));
+    m_commitPending = true;
+    m_speechActive = false;
+    qDebug() << "Committed realtime audio buffer:" << m_uncommittedAudio.size() << "bytes";
 }
 
-OpenAITranscriberRealtime::~OpenAITranscriberRealtime()
-{
-    stopStreaming();
+void OpenAITranscriberRealtime::drainSession()
+{
+    // Only one stopped session is drained at a time
+    finishDrain();
+
+    m_drainingSocket = m_webSocket;
+    m_drainingCommitPending = m_commitPending;
+    m_drainingItems = m_pendingItems;
+    m_drainingUtteranceId = m_utteranceId;
+    m_drainingUtteranceText = m_utteranceText;
+    m_webSocket = nullptr;
+    m_pendingItems.clear();
+    m_commitPending = false;
+
+    disconnect(m_drainingSocket, nullptr, this, nullptr);
+    connect(m_drainingSocket, &QWebSocket::textMessageReceived,
+            this, &OpenAITranscriberRealtime::onDrainingSocketTextMessageReceived);
+    connect(m_drainingSocket, &QWebSocket::disconnected, this, &OpenAITranscriberRealtime::finishDrain);
+
+    QWebSocket *socket = m_drainingSocket;
+    QTimer::singleShot(kDrainTimeoutMs, this, [this, socket]()
+                       {
+        if (m_drainingSocket == socket)
+        {
+            qWarning() << "Timed out waiting for the final realtime transcript";
+            finishDrain();
+        } });
+}
+
+void OpenAITranscriberRealtime::finishDrain()
+{
+    if (!m_drainingSocket)
+    {
+        return;
+    }
+
+    const bool complete = !m_drainingCommitPending && m_drainingItems.isEmpty();
+
+    disconnect(m_drainingSocket, nullptr, this, nullptr);
+    m_drainingSocket->close();
+    m_drainingSocket->deleteLater();
+    m_drainingSocket = nullptr;
+    m_drainingItems.clear();
+    m_drainingCommitPending = false;
+
+    emit utteranceTranscribed(m_drainingUtteranceId, m_drainingUtteranceText, complete);
+    m_drainingUtteranceId = 0;
+    m_drainingUtteranceText.clear();
+}
+
+void OpenAITranscriberRealtime::onDrainingSocketTextMessageReceived(const QString &message)
+{
+    RealtimeEventScanner::Event event;
+    if (!RealtimeEventScanner::scan(message, &event))
+    {
+        event = RealtimeEventScanner::fromJson(QJsonDocument::fromJson(message.toUtf8()).object());
+    }
+    const QString &type = event.type;
+
+    if (type == u"input_audio_buffer.committed")
+    {
+        m_drainingCommitPending = false;
+        m_drainingItems.insert(event.itemId);
+    }
+    else if (type == u"conversation.item.input_audio_transcription.delta")
+    {
+        processTranscriptionMessage(event.itemId, event.delta);
+    }
+    else if (type == u"conversation.item.input_audio_transcription.completed" ||
+             type == u"conversation.item.input_audio_transcription.failed")
+    {
+        m_drainingItems.remove(event.itemId);
+        processCompletedMessage(event.itemId, event.transcript);
+        appendUtteranceText(&m_drainingUtteranceText, event.transcript);
+    }
+    else if (type == u"error")
+    {
+        qWarning() << "Realtime error while finishing:" << event.errorMessage;
+        m_drainingCommitPending = false;
+    }
+
+    if (!m_drainingCommitPending && m_drainingItems.isEmpty())
+    {
+        finishDrain();
+    }
+}
+
+void OpenAITranscriberRealtime::scheduleRollover()
+{
+    m_rolloverPending = false;
+    m_rolloverTimer->start(qMax<qint64>(0, kSessionRolloverMs - m_sessionAge.elapsed()));
+}
+
+void OpenAITranscriberRealtime::onRolloverTimeout()
+{
+    if (!m_isStreaming || !m_webSocket)
+    {
+        return;
+    }
+
+    if (m_rolloverPending)
+    {
+        // No pause came in time; hand over mid-speech
+        tryRollover(true);
+        return;
+    }
+
+    qDebug() << "Realtime session is" << m_sessionAge.elapsed() / 1000 << "s old, preparing rollover";
+    m_rolloverPending = true;
+    m_rolloverTimer->start(qMax<qint64>(0, kSessionForceRolloverMs - m_sessionAge.elapsed()));
+    prepareWarmSession();
+    tryRollover(false);
+}
+
+void OpenAITranscriberRealtime::tryRollover(bool force)
+{
+    if (!m_rolloverPending || !m_isStreaming || m_fallbackActive ||
+        !m_webSocket || m_webSocket->state() != QAbstractSocket::ConnectedState || m_sessionId.isEmpty())
+    {
+        return;
+    }
+
+    if (!m_warmReady || !m_warmSocket || m_warmSocket->state() != QAbstractSocket::ConnectedState)
+    {
+        if (force)
+        {
+            qWarning() << "Realtime rollover is due but the next session is not ready";
+        }
+        return;
+    }
+
+    // A boundary is a pause after a committed item; anything still
+    // uncommitted is silence or the start of the next phrase
+    bool manual;
+    {
+        QMutexLocker locker(&m_mutex);
+        manual = m_turnDetection == TurnDetection::Manual;
+    }
+    const bool atBoundary = !m_speechActive && !m_commitPending &&
+                            (!manual || m_uncommittedAudio.size() < kMinCommitBytes);
+    if (!atBoundary && !force)
+    {
+        return;
+    }
+
+    performRollover(!atBoundary);
+}
+
+void OpenAITranscriberRealtime::performRollover(bool force)
+{
+    QByteArray overlap;
+    if (force && m_uncommittedAudio.size() + m_pendingAudio.size() >= kMinCommitBytes)
+    {
+        // The old session transcribes everything up to here; the new one
+        // hears the last moments again
+        sendPendingFrames(true);
+        sendCommit(true);
+        overlap = m_uncommittedAudio.right(kRolloverOverlapBytes);
+    }
+    else
+    {
+        // The uncommitted tail was never transcribed, so it all moves over,
+        // led by the end of the last committed item
+        overlap = m_lastCommittedTail + m_uncommittedAudio;
+    }
+
+    qDebug() << "Rolling over realtime session after" << m_sessionAge.elapsed() / 1000 << "s with"
+             << overlap.size() << "bytes of overlap" << (force ? "(forced)" : "");
+
+    // Only one session retires at a time
+    finishRetiring();
+
+    m_retiringSocket = m_webSocket;
+    m_retiringCommitPending = m_commitPending;
+    m_retiringItems = m_pendingItems;
+    m_webSocket = nullptr;
+    m_sessionId.clear();
+    m_pendingItems.clear();
+    m_commitPending = false;
+    m_speechActive = false;
+    resetReplayWindow();
+
+    // Bytes still on the old socket keep counting towards the lag
+    disconnect(m_retiringSocket, nullptr, this, nullptr);
+    connect(m_retiringSocket, &QWebSocket::textMessageReceived,
+            this, &OpenAITranscriberRealtime::onRetiringSocketTextMessageReceived);
+    connect(m_retiringSocket, &QWebSocket::bytesWritten,
+            this, &OpenAITranscriberRealtime::onWebSocketBytesWritten);
+    connect(m_retiringSocket, &QWebSocket::disconnected, this, &OpenAITranscriberRealtime::finishRetiring);
+
+    QWebSocket *socket = m_retiringSocket;
+    QTimer::singleShot(kDrainTimeoutMs, this, [this, socket]()
+                       {
+        if (m_retiringSocket == socket)
+        {
+            qWarning() << "Timed out waiting for the last transcript of the previous realtime session";
+            finishRetiring();
+        } });
+
+    if (!m_retiringCommitPending && m_retiringItems.isEmpty())
+    {
+        finishRetiring();
+    }
+
+    takeWarmSession();
+    m_overlapPending = !overlap.isEmpty();
+    m_overlapItemId.clear();
+
+    if (!overlap.isEmpty())
+    {
+        if (m_pendingAudio.isEmpty())
+        {
+            m_pendingAge.start();
+        }
+        m_pendingAudio.prepend(overlap);
+    }
+    sendPendingFrames(false);
+    prepareWarmSession();
+}
+
+void OpenAITranscriberRealtime::finishRetiring()
+{
+    if (!m_retiringSocket)
+    {
+        return;
+    }
+
+    if (m_retiringCommitPending || !m_retiringItems.isEmpty())
+    {
+        qWarning() << "Previous realtime session closed with" << m_retiringItems.size() << "items untranscribed";
+    }
+
+    disconnect(m_retiringSocket, nullptr, this, nullptr);
+    m_retiringSocket->close();
+    m_retiringSocket->deleteLater();
+    m_retiringSocket = nullptr;
+    m_retiringItems.clear();
+    m_retiringCommitPending = false;
+}
+
+void OpenAITranscriberRealtime::onRetiringSocketTextMessageReceived(const QString &message)
+{
+    RealtimeEventScanner::Event event;
+    if (!RealtimeEventScanner::scan(message, &event))
+    {
+        event = RealtimeEventScanner::fromJson(QJsonDocument::fromJson(message.toUtf8()).object());
+    }
+    const QString &type = event.type;
+
+    if (type == u"input_audio_buffer.committed")
+    {
+        m_retiringCommitPending = false;
+        m_retiringItems.insert(event.itemId);
+    }
+    else if (type == u"conversation.item.input_audio_transcription.delta")
+    {
+        processTranscriptionMessage(event.itemId, event.delta);
+    }
+    else if (type == u"conversation.item.input_audio_transcription.completed" ||
+             type == u"conversation.item.input_audio_transcription.failed")
+    {
+        m_retiringItems.remove(event.itemId);
+        if (!event.transcript.trimmed().isEmpty())
+        {
+            m_lastTranscript = event.transcript;
+        }
+        processCompletedMessage(event.itemId, event.transcript);
+        appendUtteranceText(&m_utteranceText, event.transcript);
+    }
+    else if (type == u"error")
+    {
+        qWarning() << "Realtime error on previous session:" << event.errorMessage;
+        m_retiringCommitPending = false;
+    }
+
+    if (!m_retiringCommitPending && m_retiringItems.isEmpty())
+    {
+        finishRetiring();
+    }
+}
+
+void OpenAITranscriberRealtime::setupWebSocket()
+{
+    if (m_webSocket)
+    {
+        delete m_webSocket;
+    }
+
+    // Created here so the socket belongs to the worker thread
+    m_webSocket = new QWebSocket();
+    attachWebSocket(m_webSocket);
+    m_sessionAge.start();
+    openWebSocket(m_webSocket);
+
+    scheduleRollover();
+}
+
+void OpenAITranscriberRealtime::attachWebSocket(QWebSocket *socket)
+{
+    connect(socket, &QWebSocket::connected, this, &OpenAITranscriberRealtime::onWebSocketConnected);
+    connect(socket, &QWebSocket::disconnected, this, &OpenAITranscriberRealtime::onWebSocketDisconnected);
+    connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error),
+            this, &OpenAITranscriberRealtime::onWebSocketError);
+    connect(socket, &QWebSocket::textMessageReceived,
+            this, &OpenAITranscriberRealtime::onWebSocketTextMessageReceived);
+    connect(socket, &QWebSocket::bytesWritten,
+            this, &OpenAITranscriberRealtime::onWebSocketBytesWritten);
+    connect(socket, &QWebSocket::pong, this, &OpenAITranscriberRealtime::onWebSocketPong);
+}
+
+void OpenAITranscriberRealtime::openWebSocket(QWebSocket *socket)
+{
+    // Connect to OpenAI Realtime API with authentication
+    QUrl url("wss://api.openai.com/v1/realtime?intent=transcription");
+
+    // Set up headers for authentication
+    QNetworkRequest request(url);
+    QString apiKey;
+    {
+        QMutexLocker locker(&m_mutex);
+        apiKey = m_apiKey;
+    }
+    request.setRawHeader("Authorization", QString("Bearer %1").arg(apiKey).toUtf8());
+    request.setRawHeader("openai-beta", "realtime=v1");
+    request.setRawHeader("input_audio_format", "pcm16");
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+    socket->open(request);
+}
+
+void OpenAITranscriberRealtime::prepareWarmSession()
+{
+    {
+        // A rollover needs the next session even when warm starts are off
+        QMutexLocker locker(&m_mutex);
+        if ((!m_warmSessionEnabled && !m_rolloverPending) || m_apiKey.isEmpty() || m_warmAuthFailed)
+        {
+            return;
+        }
+    }
+
+    if (m_warmSocket)
+    {
+        return;
+    }
+
+    m_warmSocket = new QWebSocket();
+    m_warmSessionId.clear();
+    m_warmReady = false;
+    m_warmAge.start();
+
+    connect(m_warmSocket, &QWebSocket::textMessageReceived,
+            this, &OpenAITranscriberRealtime::onWarmSocketTextMessageReceived);
+    connect(m_warmSocket, &QWebSocket::disconnected,
+            this, &OpenAITranscriberRealtime::onWarmSocketDisconnected);
+    connect(m_warmSocket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error),
+            this, &OpenAITranscriberRealtime::onWarmSocketError);
+    connect(m_warmSocket, &QWebSocket::pong, this, &OpenAITranscriberRealtime::onWebSocketPong);
+    connect(m_warmSocket, &QWebSocket::connected, this, [this]()
+            {
+        if (m_networkEstimator)
+        {
+            m_networkEstimator->recordHandshake(m_warmAge.elapsed());
+        } });
+    openWebSocket(m_warmSocket);
+}
+
+void OpenAITranscriberRealtime::discardWarmSession()
+{
+    m_warmRefreshTimer->stop();
+    m_warmPingTimer->stop();
+
+    if (m_warmSocket)
+    {
+        disconnect(m_warmSocket, nullptr, this, nullptr);
+        m_warmSocket->close();
+        m_warmSocket->deleteLater();
+        m_warmSocket = nullptr;
+    }
+
+    m_warmSessionId.clear();
+    m_warmReady = false;
+}
+
+void OpenAITranscriberRealtime::onWarmSocketTextMessageReceived(const QString &message)
+{
+    if (sender() != m_warmSocket)
+    {
+        return;
+    }
+
+    QJsonObject jsonObj = QJsonDocument::fromJson(message.toUtf8()).object();
+    QString type = jsonObj["type"].toString();
+
+    if (type == "transcription_session.created")
+    {
+        m_warmSessionId = jsonObj["session"].toObject()["id"].toString();
+        sendSessionUpdate(m_warmSocket);
+    }
+    else if (type == "transcription_session.updated")
+    {
+        m_warmReady = true;
+        m_warmRetryDelayMs = kWarmSessionRetryMs;
+        m_warmRefreshTimer->start();
+        qDebug() << "Warm realtime session ready in" << m_warmAge.elapsed() << "ms";
+
+        // Keeps the round-trip estimate fresh while nothing is streaming, so
+        // the engine choice can recover once the link does
+        m_warmSocket->ping();
+        m_warmPingTimer->start();
+
+        if (m_rolloverPending)
+        {
+            tryRollover(false);
+        }
+    }
+    else if (type == "error")
+    {
+        const QJsonObject error = jsonObj["error"].toObject();
+        qWarning() << "Warm realtime session error:" << error["message"].toString();
+        if (isAuthErrorCode(error["code"].toString()))
+        {
+            QMutexLocker locker(&m_mutex);
+            m_warmAuthFailed = true;
+        }
+    }
+}
+
+void OpenAITranscriberRealtime::onWarmSocketDisconnected()
+{
+    if (sender() != m_warmSocket)
+    {
+        return;
+    }
+
+    retryWarmSession();
+}
+
+void OpenAITranscriberRealtime::onWarmSocketError(QAbstractSocket::SocketError error)
+{
+    if (sender() != m_warmSocket)
+    {
+        return;
+    }
+
+    qWarning() << "Warm realtime session error:" << error << m_warmSocket->errorString();
+    if (isAuthFailure(m_warmSocket->errorString()))
+    {
+        QMutexLocker locker(&m_mutex);
+        m_warmAuthFailed = true;
+    }
+
+    // A socket that never connected is not followed by disconnected()
+    if (m_warmSocket->state() == QAbstractSocket::UnconnectedState)
+    {
+        retryWarmSession();
+    }
+}
+
+void OpenAITranscriberRealtime::retryWarmSession()
+{
+    discardWarmSession();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_warmAuthFailed)
+        {
+            qWarning() << "Warm realtime session rejected the API key, not retrying until it changes";
+            return;
+        }
+    }
+
+    // Back off while offline so the API is not polled at a fixed rate
+    qDebug() << "Warm realtime session closed, reconnecting in" << m_warmRetryDelayMs << "ms";
+    QTimer::singleShot(m_warmRetryDelayMs, this, &OpenAITranscriberRealtime::prepareWarmSession);
+    m_warmRetryDelayMs = qMin(m_warmRetryDelayMs * 2, kMaxWarmSessionRetryMs);
+}
+
+void OpenAITranscriberRealtime::recordStartLatency(bool warm)
+{
+    qint64 elapsed = m_startTimer.elapsed();
+    qDebug() << (warm ? "Realtime warm start:" : "Realtime cold start:") << elapsed << "ms";
+
+    QMutexLocker locker(&m_mutex);
+    if (warm)
+    {
+        m_startStats.warmStarts++;
+        m_startStats.totalWarmStartMs += elapsed;
+    }
+    else
+    {
+        m_startStats.coldStarts++;
+        m_startStats.totalColdStartMs += elapsed;
+    }
+}
+
+void OpenAITranscriberRealtime::onWebSocketConnected()
+{
+    qDebug() << "WebSocket connected to OpenAI Realtime API";
+
+    if (m_networkEstimator && sender() == m_webSocket)
+    {
+        m_networkEstimator->recordHandshake(m_sessionAge.elapsed());
+    }
+
+    // Audio is held back until the transcription session has been created
+}
+
+void OpenAITranscriberRealtime::onWebSocketDisconnected()
+{
+    qDebug() << "WebSocket disconnected from OpenAI Realtime API";
+
+    if (m_isStreaming && sender() == m_webSocket)
+    {
+        handleConnectionLoss();
+    }
+}
+
+void OpenAITranscriberRealtime::onWebSocketError(QAbstractSocket::SocketError error)
+{
+    qWarning() << "WebSocket error:" << error;
+
+    // While streaming, a failed socket is recovered by reconnecting
+    if (m_isStreaming && sender() == m_webSocket && m_webSocket->state() == QAbstractSocket::UnconnectedState)
+    {
+        handleConnectionLoss();
+        return;
+    }
+
+    if (!m_isStreaming)
+    {
+        emit transcriptionError(QString("WebSocket error: %1").arg(error));
+    }
 }
 
-void OpenAITranscriberRealtime::setApiKey(const QString &apiKey)
+bool OpenAITranscriberRealtime::takeWarmSession()
 {
-    m_apiKey = apiKey;
-}
+    if (!m_warmReady || !m_warmSocket || m_warmSocket->state() != QAbstractSocket::ConnectedState)
+    {
+        return false;
+    }
 
-void OpenAITranscriberRealtime::setAudioBuffer(AudioBuffer *buffer)
-{
-    m_audioBuffer = buffer;
+    // Take over the configured session so audio can flow immediately
+    m_warmRefreshTimer->stop();
+    m_warmPingTimer->stop();
+    delete m_webSocket;
+    m_webSocket = m_warmSocket;
+    m_sessionId = m_warmSessionId;
+    m_warmSocket = nullptr;
+    m_warmReady = false;
+
+    disconnect(m_webSocket, nullptr, this, nullptr);
+    attachWebSocket(m_webSocket);
+
+    // The session's lifetime started when the warm socket was opened
+    m_sessionAge = m_warmAge;
+    scheduleRollover();
+    return true;
 }
 
-void OpenAITranscriberRealtime::startStreaming()
+void OpenAITranscriberRealtime::handleConnectionLoss()
 {
-    if (m_isStreaming)
+    // The failed socket may still be inside one of its own signals
+    disconnect(m_webSocket, nullptr, this, nullptr);
+    m_webSocket->deleteLater();
+    m_webSocket = nullptr;
+    m_sessionId.clear();
+    m_commitPending = false;
+    m_pendingItems.clear();
+    m_speechActive = false;
+
+    // Whatever the old socket still held is resent with the replay
     {
-        qDebug() << "Already streaming, ignoring start request";
-        return;
+        QMutexLocker locker(&m_mutex);
+        m_frameStats.queuedBytes = 0;
     }
+    m_catchUpBytes = 0;
+    m_throughputTimer.invalidate();
+
+    // The replacement session starts a fresh lifetime
+    m_rolloverTimer->stop();
+    m_rolloverPending = false;
 
-    if (m_apiKey.isEmpty())
+    if (m_networkEstimator)
     {
-        emit transcriptionError("API key not set");
-        return;
+        m_networkEstimator->recordOutcome(false);
     }
 
-    if (!m_audioBuffer)
+    if (m_reconnectAttempts >= kMaxReconnectAttempts)
     {
-        emit transcriptionError("Circular buffer not set");
+        qWarning() << "Realtime reconnection failed after" << m_reconnectAttempts << "attempts";
+        m_utteranceFailed = true;
+        emit transcriptionError("WebSocket connection lost");
+        endStreaming();
         return;
     }
 
-    QMutexLocker locker(&m_mutex);
-    m_isStreaming = true;
-    m_lastProcessedData.clear();
-    m_sessionId = "";
-    m_currentItemId = "";
+    // Everything the server has not transcribed yet goes out again, ahead
+    // of the audio captured while reconnecting
+    QByteArray replay;
+    for (const CommittedAudio &item : std::as_const(m_committedAudio))
+    {
+        replay.append(item.audio);
+    }
+    replay.append(m_uncommittedAudio);
+    if (!replay.isEmpty())
+    {
+        if (m_pendingAudio.isEmpty())
+        {
+            m_pendingAge.start();
+        }
+        m_pendingAudio.prepend(replay);
+    }
+    resetReplayWindow();
 
-    setupWebSocket();
-    emit streamingStarted();
+    int delay = qMin(kBaseReconnectDelayMs << qMin(m_reconnectAttempts, 8), kMaxReconnectDelayMs);
+    m_reconnectAttempts++;
+    m_reconnectTimer.start();
+    qDebug() << "Realtime connection lost, reconnecting in" << delay << "ms with" << replay.size() << "bytes to replay";
+
+    QTimer::singleShot(delay, this, [this]()
+                       { reconnect(); });
 }
 
-void OpenAITranscriberRealtime::stopStreaming()
+void OpenAITranscriberRealtime::reconnect()
 {
-    if (!m_isStreaming)
+    if (!m_isStreaming || m_webSocket || m_fallbackActive)
     {
         return;
     }
 
-    QMutexLocker locker(&m_mutex);
-    m_isStreaming = false;
+    if (takeWarmSession())
+    {
+        qDebug() << "Realtime session resumed on warm session after" << m_reconnectTimer.elapsed() << "ms";
+        sendCatchUpFrames();
+        prepareWarmSession();
+    }
+    else
+    {
+        setupWebSocket();
+    }
+}
+
+void OpenAITranscriberRealtime::resetReplayWindow()
+{
+    m_committedAudio.clear();
+    m_uncommittedAudio.clear();
+    m_uncommittedOffset = 0;
+    m_speechEndOffset = -1;
+    m_lastCommittedTail.clear();
+}
 
-    if (m_timer)
+void OpenAITranscriberRealtime::trimReplayWindow()
+{
+    qsizetype total = m_uncommittedAudio.size();
+    for (const CommittedAudio &item : std::as_const(m_committedAudio))
     {
-        m_timer->stop();
+        total += item.audio.size();
     }
 
-    if (m_webSocket)
+    // Drop the oldest audio first
+    while (total > kMaxReplayBytes && !m_committedAudio.isEmpty())
     {
-        m_webSocket->close();
-        delete m_webSocket;
-        m_webSocket = nullptr;
+        total -= m_committedAudio.takeFirst().audio.size();
     }
 
-    emit streamingStopped();
+    if (total > kMaxReplayBytes)
+    {
+        qsizetype excess = total - kMaxReplayBytes;
+        m_uncommittedAudio.remove(0, excess);
+        m_uncommittedOffset += excess;
+    }
 }
 
-bool OpenAITranscriberRealtime::isStreaming() const
+void OpenAITranscriberRealtime::onWebSocketTextMessageReceived(const QString &message)
 {
-    return m_isStreaming;
+    // Frequent events are handled straight from a field scan
+    RealtimeEventScanner::Event event;
+    if (RealtimeEventScanner::scan(message, &event) && handleEvent(event))
+    {
+        return;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(message.toUtf8(), &parseError);
+
+    if (parseError.error != QJsonParseError::NoError)
+    {
+        qWarning() << "Failed to parse WebSocket message:" << parseError.errorString();
+        return;
+    }
+
+    QJsonObject jsonObj = doc.object();
+    QString type = jsonObj["type"].toString();
+
+    // qDebug() << "Received message:" << message;
+
+    if (type == "transcription_session.created")
+    {
+        m_sessionId = jsonObj["session"].toObject()["id"].toString();
+        qDebug() << "Transcription session created with ID:" << m_sessionId;
+
+        sendSessionUpdate(m_webSocket);
+
+        if (m_coldStartPending)
+        {
+            m_coldStartPending = false;
+            recordStartLatency(false);
+        }
+
+        if (m_reconnectTimer.isValid())
+        {
+            qDebug() << "Realtime session resumed after" << m_reconnectTimer.elapsed() << "ms";
+            m_reconnectTimer.invalidate();
+        }
+        m_reconnectAttempts = 0;
+
+        if (m_networkEstimator)
+        {
+            m_networkEstimator->recordOutcome(true);
+        }
+        m_webSocket->ping();
+
+        // Send the audio captured while the connection was being set up
+        sendCatchUpFrames();
+    }
+    else if (!handleEvent(RealtimeEventScanner::fromJson(jsonObj)))
+    {
+        qDebug() << "Received message type:" << type;
+    }
 }
 
-void OpenAITranscriberRealtime::setupWebSocket()
+bool OpenAITranscriberRealtime::handleEvent(const RealtimeEventScanner::Event &event)
 {
-    if (m_webSocket)
+    const QString &type = event.type;
+
+    if (type == u"conversation.item.input_audio_transcription.delta")
     {
-        delete m_webSocket;
+        releaseCommittedAudio(event.itemId);
+        // Overlap text is only known once the whole item has been transcribed
+        if (event.itemId != m_overlapItemId)
+        {
+            processTranscriptionMessage(event.itemId, event.delta);
+        }
+    }
+    else if (type == u"input_audio_buffer.committed")
+    {
+        processCommittedMessage(event.itemId, event.previousItemId);
+        if (m_overlapPending)
+        {
+            m_overlapPending = false;
+            m_overlapItemId = event.itemId;
+        }
+        if (m_rolloverPending)
+        {
+            tryRollover(false);
+        }
+    }
+    else if (type == u"input_audio_buffer.speech_started")
+    {
+        m_speechActive = true;
+    }
+    else if (type == u"input_audio_buffer.speech_stopped")
+    {
+        m_speechActive = false;
+        // Where the server will cut the next committed item
+        if (event.audioEndMs >= 0)
+        {
+            m_speechEndOffset = event.audioEndMs * kBytesPerMs;
+        }
     }
+    else if (type == u"conversation.item.input_audio_transcription.completed" ||
+             type == u"conversation.item.input_audio_transcription.failed")
+    {
+        releaseCommittedAudio(event.itemId);
+        m_pendingItems.remove(event.itemId);
 
-    m_webSocket = new QWebSocket();
+        QString transcript = event.transcript;
+        if (event.itemId == m_overlapItemId)
+        {
+            m_overlapItemId.clear();
+            transcript = removeOverlap(m_lastTranscript, transcript);
+        }
+        if (!transcript.trimmed().isEmpty())
+        {
+            m_lastTranscript = transcript;
+        }
 
-    // Connect signals
-    connect(m_webSocket, &QWebSocket::connected, this, &OpenAITranscriberRealtime::onWebSocketConnected);
-    connect(m_webSocket, &QWebSocket::disconnected, this, &OpenAITranscriberRealtime::onWebSocketDisconnected);
-    connect(m_webSocket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error),
-            this, &OpenAITranscriberRealtime::onWebSocketError);
-    connect(m_webSocket, &QWebSocket::textMessageReceived,
-            this, &OpenAITranscriberRealtime::onWebSocketTextMessageReceived);
+        processCompletedMessage(event.itemId, transcript);
+        appendUtteranceText(&m_utteranceText, transcript);
+    }
+    else if (type == u"error")
+    {
+        qWarning() << "Received error from OpenAI API:" << event.errorMessage;
+        m_commitPending = false;
+        emit transcriptionError(event.errorMessage);
+    }
+    else
+    {
+        // Everything else goes through the QJsonDocument path
+        return false;
+    }
 
-    // Connect to OpenAI Realtime API with authentication
-    QUrl url("wss://api.openai.com/v1/realtime?intent=transcription");
+    return true;
+}
 
-    // Set up headers for authentication
-    QNetworkRequest request(url);
-    request.setRawHeader("Authorization", QString("Bearer %1").arg(m_apiKey).toUtf8());
-    request.setRawHeader("openai-beta", "realtime=v1");
-    request.setRawHeader("input_audio_format", "pcm16");
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+void OpenAITranscriberRealtime::onWebSocketBytesWritten(qint64 bytes)
+{
+    qint64 queued;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_frameStats.queuedBytes = qMax<qint64>(0, m_frameStats.queuedBytes - bytes);
+        queued = m_frameStats.queuedBytes;
+    }
+
+    // The socket writes in order, so the catch-up burst goes out first
+    m_catchUpBytes = qMax<qint64>(0, m_catchUpBytes - bytes);
+
+    // Only a backlogged socket shows what the link can carry; while idle the
+    // rate is just the microphone's
+    if (m_networkEstimator)
+    {
+        if (m_throughputTimer.isValid())
+        {
+            m_throughputBytes += bytes;
+            if (queued == 0 || m_throughputTimer.elapsed() >= kThroughputWindowMs)
+            {
+                m_networkEstimator->recordThroughput(m_throughputBytes, m_throughputTimer.elapsed());
+                m_throughputTimer.invalidate();
+            }
+        }
+        if (queued > 0 && !m_throughputTimer.isValid())
+        {
+            m_throughputTimer.start();
+            m_throughputBytes = 0;
+        }
+    }
 
-    m_webSocket->open(request);
+    updateNetworkLag();
 }
 
-void OpenAITranscriberRealtime::onWebSocketConnected()
+void OpenAITranscriberRealtime::onWebSocketPong(quint64 elapsedTime, const QByteArray &payload)
 {
-    qDebug() << "WebSocket connected to OpenAI Realtime API";
+    Q_UNUSED(payload);
 
-    // Send session update message
-    // Start timer for periodic audio processing
-    m_timer->start();
+    if (m_networkEstimator)
+    {
+        m_networkEstimator->recordRtt(static_cast<qint64>(elapsedTime));
+    }
 }
 
-void OpenAITranscriberRealtime::onWebSocketDisconnected()
+int OpenAITranscriberRealtime::queuedAudioMs() const
 {
-    qDebug() << "WebSocket disconnected from OpenAI Realtime API";
-    m_timer->stop();
+    // Queued bytes are base64 text, four characters per three PCM bytes
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_frameStats.queuedBytes * 3 / 4 / kBytesPerMs);
+}
 
-    if (m_isStreaming)
+void OpenAITranscriberRealtime::sendCatchUpFrames()
+{
+    qint64 before;
     {
-        emit transcriptionError("WebSocket connection lost");
+        QMutexLocker locker(&m_mutex);
+        before = m_frameStats.queuedBytes;
     }
+
+    sendPendingFrames(false);
+
+    QMutexLocker locker(&m_mutex);
+    m_catchUpBytes += m_frameStats.queuedBytes - before;
 }
 
-void OpenAITranscriberRealtime::onWebSocketError(QAbstractSocket::SocketError error)
+void OpenAITranscriberRealtime::updateNetworkLag()
 {
-    qWarning() << "WebSocket error:" << error;
-    emit transcriptionError(QString("WebSocket error: %1").arg(error));
+    if (!m_isStreaming || m_fallbackActive)
+    {
+        return;
+    }
+
+    // Only a connected session can fall behind. While reconnecting, the
+    // attempt limit in handleConnectionLoss() decides instead, so a short
+    // outage reconnects and replays rather than switching to batch.
+    if (!m_webSocket || m_webSocket->state() != QAbstractSocket::ConnectedState || m_sessionId.isEmpty())
+    {
+        return;
+    }
+
+    // Audio the socket has not written, less the catch-up burst, plus audio
+    // waiting for a whole frame. Queued bytes are base64 text, four
+    // characters per three PCM bytes.
+    qint64 queuedBytes;
+    {
+        QMutexLocker locker(&m_mutex);
+        queuedBytes = qMax<qint64>(0, m_frameStats.queuedBytes - m_catchUpBytes);
+    }
+    int lagMs = static_cast<int>(queuedBytes * 3 / 4 / kBytesPerMs + m_pendingAudio.size() / kBytesPerMs);
+
+    if (qAbs(lagMs - m_reportedLagMs) >= kLagReportStepMs || (lagMs == 0 && m_reportedLagMs != 0))
+    {
+        m_reportedLagMs = lagMs;
+        emit networkLagChanged(lagMs);
+    }
+
+    if (lagMs >= kFallbackLagMs)
+    {
+        startBatchFallback();
+    }
 }
 
-void OpenAITranscriberRealtime::onWebSocketTextMessageReceived(const QString &message)
+void OpenAITranscriberRealtime::startBatchFallback()
 {
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(message.toUtf8(), &parseError);
+    qWarning() << "Realtime uplink is" << m_reportedLagMs << "ms behind, switching this utterance to batch";
 
-    if (parseError.error != QJsonParseError::NoError)
+    if (m_networkEstimator)
     {
-        qWarning() << "Failed to parse WebSocket message:" << parseError.errorString();
-        return;
+        m_networkEstimator->recordOutcome(false);
     }
 
-    QJsonObject jsonObj = doc.object();
-    QString type = jsonObj["type"].toString();
+    // Collect everything the server has not transcribed; the rest of the
+    // utterance is appended as it is captured
+    m_fallbackAudio.clear();
+    for (const CommittedAudio &item : std::as_const(m_committedAudio))
+    {
+        m_fallbackAudio.append(item.audio);
+    }
+    m_fallbackAudio.append(m_uncommittedAudio);
+    m_fallbackAudio.append(m_pendingAudio);
+    m_pendingAudio.clear();
+    resetReplayWindow();
+    m_fallbackActive = true;
 
-    // qDebug() << "Received message:" << message;
+    if (m_webSocket)
+    {
+        disconnect(m_webSocket, nullptr, this, nullptr);
+        m_webSocket->abort();
+        m_webSocket->deleteLater();
+        m_webSocket = nullptr;
+    }
+    m_sessionId.clear();
+    m_commitPending = false;
+    m_pendingItems.clear();
 
-    if (type == "transcription_session.created")
+    m_reportedLagMs = 0;
+    emit networkLagChanged(0);
+}
+
+void OpenAITranscriberRealtime::onAudioAvailable()
+{
+    if (!m_isStreaming || !m_audioBuffer)
     {
-        m_sessionId = jsonObj["session"].toObject()["id"].toString();
-        qDebug() << "Transcription session created with ID:" << m_sessionId;
+        return;
+    }
 
-        sendSessionUpdate();
+    bool keepRecordedAudio;
+    {
+        QMutexLocker locker(&m_mutex);
+        keepRecordedAudio = m_keepRecordedAudio;
     }
-    else if (type == "input_audio_buffer.committed")
+
+    // Otherwise the buffer is drained so long streams do not grow it
+    QByteArray data = keepRecordedAudio ? m_audioBuffer->readFrom(m_bufferReadOffset) : m_audioBuffer->readAndClear();
+    if (data.isEmpty())
     {
-        processCommittedMessage(jsonObj);
+        return;
     }
-    else if (type == "conversation.item.input_audio_transcription.delta")
+    if (keepRecordedAudio)
     {
-        processTranscriptionMessage(jsonObj);
+        m_bufferReadOffset += data.size();
     }
-    else if (type == "error")
+
+    if (m_fallbackActive)
     {
-        QString errorMessage = jsonObj["error"].toObject()["message"].toString();
-        qWarning() << "Received error from OpenAI API:" << errorMessage;
-        emit transcriptionError(errorMessage);
+        m_fallbackAudio.append(data);
+        return;
     }
-    else
+
+    if (m_pendingAudio.isEmpty())
     {
-        qDebug() << "Received message type:" << type;
+        m_pendingAge.start();
     }
+    m_pendingAudio.append(data);
+
+    sendPendingFrames(false);
+    updateNetworkLag();
 }
 
-void OpenAITranscriberRealtime::onTimerTimeout()
+void OpenAITranscriberRealtime::sendPendingFrames(bool flush)
 {
-    if (!m_isStreaming || !m_audioBuffer || !m_webSocket)
+    if (!m_webSocket || m_webSocket->state() != QAbstractSocket::ConnectedState || m_sessionId.isEmpty())
     {
         return;
     }
 
-    // Get current audio data from circular buffer
-    QByteArray currentData = m_audioBuffer->readAndClear();
+    int frameMs;
+    {
+        QMutexLocker locker(&m_mutex);
+        frameMs = m_frameMs;
+    }
 
-    if (currentData.isEmpty())
+    // When the socket is behind, batch into larger frames to cut per-message
+    // overhead until the queue drains
+    const int queuedMs = queuedAudioMs();
+    if (queuedMs > frameMs)
     {
-        qDebug() << "No data to send";
-        return;
+        frameMs = qMin(queuedMs, kMaxFrameMs);
+    }
+    const qsizetype frameBytes = static_cast<qsizetype>(frameMs) * kBytesPerMs;
+
+    // Send whole frames; a partial frame only goes out when flushing
+    qsizetype offset = 0;
+    while (m_pendingAudio.size() - offset >= frameBytes || (flush && offset < m_pendingAudio.size()))
+    {
+        qsizetype length = qMin(frameBytes, m_pendingAudio.size() - offset);
+        sendAudioBuffer(m_pendingAudio.constData() + offset, length);
+        offset += length;
+
+        // The oldest byte of the frame has waited since the pending audio started
+        qint64 delay = m_pendingAge.elapsed();
+        QMutexLocker locker(&m_mutex);
+        m_frameStats.frames++;
+        m_frameStats.bytesSent += length;
+        m_frameStats.totalFrameDelayMs += delay;
+        m_frameStats.maxFrameDelayMs = qMax(m_frameStats.maxFrameDelayMs, delay);
     }
 
-    // Only send new data since last processing
-    sendAudioBuffer(currentData);
+    if (offset > 0)
+    {
+        m_pendingAudio.remove(0, offset);
+        m_pendingAge.start();
+    }
 }
 
-void OpenAITranscriberRealtime::sendSessionUpdate()
+void OpenAITranscriberRealtime::sendSessionUpdate(QWebSocket *socket)
 {
     QJsonObject sessionUpdate = createSessionUpdateMessage();
     QJsonDocument doc(sessionUpdate);
     QString message = doc.toJson(QJsonDocument::Compact);
 
-    if (m_webSocket && m_webSocket->state() == QAbstractSocket::ConnectedState)
+    if (socket && socket->state() == QAbstractSocket::ConnectedState)
     {
-        m_webSocket->sendTextMessage(message);
+        socket->sendTextMessage(message);
         qDebug() << "Sent session update message";
     }
 }
 
-void OpenAITranscriberRealtime::sendAudioBuffer(const QByteArray &audioData)
+void OpenAITranscriberRealtime::sendAudioBuffer(const char *audioData, qsizetype size)
 {
     if (!m_webSocket || m_webSocket->state() != QAbstractSocket::ConnectedState || m_sessionId.isEmpty())
     {
         return;
     }
 
-    QJsonObject audioMessage;
-    audioMessage["type"] = "input_audio_buffer.append";
-    audioMessage["audio"] = QString::fromUtf8(encodeBase64(audioData));
-
-    QJsonDocument doc(audioMessage);
-    QString message = doc.toJson(QJsonDocument::Compact);
-
-    qDebug() << "Sending audio buffer message length: " << message.length();
+    // The message is pure ASCII; QWebSocket only takes text frames as QString
+    const QByteArray &message = m_messageEncoder.encodeAppend(audioData, size);
+    qint64 sent = m_webSocket->sendTextMessage(QString::fromLatin1(message));
 
-    m_webSocket->sendTextMessage(message);
-}
+    // Keep the audio until the server has committed and transcribed it
+    m_uncommittedAudio.append(audioData, size);
+    trimReplayWindow();
 
-QByteArray OpenAITranscriberRealtime::encodeBase64(const QByteArray &data)
-{
-    return data.toBase64();
+    QMutexLocker locker(&m_mutex);
+    m_frameStats.queuedBytes += sent;
+    m_frameStats.maxQueuedBytes = qMax(m_frameStats.maxQueuedBytes, m_frameStats.queuedBytes);
 }
 
 QJsonObject OpenAITranscriberRealtime::createSessionUpdateMessage()
@@ -257,12 +1533,26 @@ QJsonObject OpenAITranscriberRealtime::createSessionUpdateMessage()
 
     QJsonObject session;
 
-    QJsonObject turnDetection;
-    turnDetection["type"] = "server_vad";
-    turnDetection["threshold"] = 0.5;
-    turnDetection["prefix_padding_ms"] = 300;
-    turnDetection["silence_duration_ms"] = 60;
-    session["turn_detection"] = turnDetection;
+    bool manual;
+    {
+        QMutexLocker locker(&m_mutex);
+        manual = m_turnDetection == TurnDetection::Manual;
+    }
+
+    if (manual)
+    {
+        // The client commits each turn itself
+        session["turn_detection"] = QJsonValue::Null;
+    }
+    else
+    {
+        QJsonObject turnDetection;
+        turnDetection["type"] = "server_vad";
+        turnDetection["threshold"] = 0.5;
+        turnDetection["prefix_padding_ms"] = 300;
+        turnDetection["silence_duration_ms"] = 60;
+        session["turn_detection"] = turnDetection;
+    }
 
     // QJsonObject noiseReduction;
     // noiseReduction["type"] = "near_field";
@@ -276,22 +1566,119 @@ QJsonObject OpenAITranscriberRealtime::createSessionUpdateMessage()
     return sessionUpdate;
 }
 
-void OpenAITranscriberRealtime::processTranscriptionMessage(const QJsonObject &message)
+void OpenAITranscriberRealtime::processTranscriptionMessage(const QString &itemId, const QString &text)
 {
-    QString text = message["delta"].toString();
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_liveTypingEnabled)
+        {
+            return;
+        }
+    }
+
+    if (text.isEmpty())
+    {
+        return;
+    }
 
-    if (!text.isEmpty())
+    // The first delta of an item starts a new phrase; later ones continue it
+    QString &typed = m_typedText[itemId];
+    if (typed.isEmpty() || itemId != m_lastTypedItemId)
     {
         emit transcriptionReceived(text);
-        // qDebug() << "Transcription received:" << text;
     }
+    else
+    {
+        emit transcriptionDelta(text);
+    }
+
+    typed.append(text);
+    m_lastTypedItemId = itemId;
+}
+
+void OpenAITranscriberRealtime::appendUtteranceText(QString *utterance, const QString &transcript)
+{
+    const QString text = transcript.trimmed();
+    if (text.isEmpty())
+    {
+        return;
+    }
+    if (!utterance->isEmpty())
+    {
+        utterance->append(' ');
+    }
+    utterance->append(text);
+}
+
+void OpenAITranscriberRealtime::processCompletedMessage(const QString &itemId, const QString &transcript)
+{
+    const QString typed = m_typedText.take(itemId);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_liveTypingEnabled)
+        {
+            return;
+        }
+    }
+
+    // Models without delta streaming only deliver the completed transcript
+    if (typed.isEmpty())
+    {
+        if (!transcript.isEmpty())
+        {
+            emit transcriptionReceived(transcript);
+            m_lastTypedItemId = itemId;
+        }
+        return;
+    }
+
+    if (transcript.isEmpty() || transcript == typed)
+    {
+        return;
+    }
+
+    // Backspacing is only safe while this item's text ends at the cursor
+    if (itemId != m_lastTypedItemId)
+    {
+        qDebug() << "Skipping correction for item" << itemId << "- later text already typed";
+        return;
+    }
+
+    emit transcriptionRevised(typed, transcript);
 }
 
-void OpenAITranscriberRealtime::processCommittedMessage(const QJsonObject &message)
+void OpenAITranscriberRealtime::processCommittedMessage(const QString &itemId, const QString &previousItemId)
 {
-    QJsonObject committed = message["committed"].toObject();
-    m_currentItemId = committed["item_id"].toString();
-    QString previousItemId = committed["previous_item_id"].toString();
+    m_currentItemId = itemId;
+    m_commitPending = false;
+    m_pendingItems.insert(m_currentItemId);
 
     qDebug() << "Audio buffer committed - Item ID:" << m_currentItemId << "Previous:" << previousItemId;
+
+    // Move the committed span out of the uncommitted tail; without a known
+    // speech end, everything sent so far belongs to this item
+    qsizetype cut = m_uncommittedAudio.size();
+    if (m_speechEndOffset >= 0)
+    {
+        cut = qBound<qsizetype>(0, m_speechEndOffset - m_uncommittedOffset, m_uncommittedAudio.size());
+    }
+
+    m_committedAudio.append({m_currentItemId, m_uncommittedAudio.left(cut)});
+    m_lastCommittedTail = m_committedAudio.constLast().audio.right(kRolloverOverlapBytes);
+    m_uncommittedAudio.remove(0, cut);
+    m_uncommittedOffset += cut;
+    m_speechEndOffset = -1;
+}
+
+void OpenAITranscriberRealtime::releaseCommittedAudio(const QString &itemId)
+{
+    // Once text for an item arrives, replaying it would type it twice
+    for (qsizetype i = 0; i < m_committedAudio.size(); ++i)
+    {
+        if (m_committedAudio.at(i).itemId == itemId)
+        {
+            m_committedAudio.removeAt(i);
+            return;
+        }
+    }
 }
\ No newline at end of file
@@ -10,55 +10,241 @@
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QJsonArray>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QHash>
+#include "audiomessageencoder.h"
+#include "realtimeeventscanner.h"
 
 class AudioBuffer;
+class NetworkQualityEstimator;
 
+// Streams microphone audio to the Realtime API. Sending is driven by writes
+// to the audio buffer, which are grouped into fixed-length frames. The
+// transcriber is meant to live on a worker thread; the public methods are
+// thread-safe and results arrive through queued signals.
 class OpenAITranscriberRealtime : public QObject
 {
     Q_OBJECT
 
 public:
+    struct FrameStats
+    {
+        int frames = 0;
+        qint64 bytesSent = 0;
+        qint64 queuedBytes = 0;
+        qint64 maxQueuedBytes = 0;
+        qint64 totalFrameDelayMs = 0;
+        qint64 maxFrameDelayMs = 0;
+    };
+
+    // Who decides that an utterance is over: the server's voice activity
+    // detection, or the client committing the audio buffer (push-to-talk)
+    enum class TurnDetection
+    {
+        ServerVad,
+        Manual
+    };
+
+    struct StartStats
+    {
+        int coldStarts = 0;
+        int warmStarts = 0;
+        qint64 totalColdStartMs = 0;
+        qint64 totalWarmStartMs = 0;
+    };
+
     explicit OpenAITranscriberRealtime(QObject *parent = nullptr);
     ~OpenAITranscriberRealtime();
 
     void setApiKey(const QString &apiKey);
     void setAudioBuffer(AudioBuffer *buffer);
-    void startStreaming();
+    // utteranceId is echoed back by utteranceTranscribed()
+    void startStreaming(quint64 utteranceId = 0);
     void stopStreaming();
     bool isStreaming() const;
+    void setFrameMs(int ms);
+    int frameMs() const;
+    FrameStats frameStats() const;
+    void setWarmSessionEnabled(bool enabled);
+    StartStats startStats() const;
+    void setTurnDetection(TurnDetection mode);
+    void commitTurn();
+    void setLiveTypingEnabled(bool enabled);
+    void setKeepRecordedAudio(bool enabled);
+    void setNetworkQualityEstimator(NetworkQualityEstimator *estimator);
 
 signals:
     void transcriptionReceived(const QString &text);
+    // Continuation of the item started by the last transcriptionReceived
+    void transcriptionDelta(const QString &text);
+    // The completed transcript differs from what the deltas typed
+    void transcriptionRevised(const QString &typed, const QString &text);
     void transcriptionError(const QString &error);
     void streamingStarted();
     void streamingStopped();
+    // How far the uplink trails the microphone, in milliseconds of audio
+    void networkLagChanged(int ms);
+    // The session fell too far behind; the utterance should be transcribed
+    // from this audio through the batch path instead
+    void batchFallbackRequested(const QByteArray &audio);
+    // Final text of a stopped stream, exactly once per startStreaming();
+    // complete is false if the session failed or timed out before every
+    // item was transcribed
+    void utteranceTranscribed(quint64 utteranceId, const QString &text, bool complete);
 
 private slots:
     void onWebSocketConnected();
     void onWebSocketDisconnected();
     void onWebSocketError(QAbstractSocket::SocketError error);
     void onWebSocketTextMessageReceived(const QString &message);
-    void onTimerTimeout();
+    void onWebSocketBytesWritten(qint64 bytes);
+    void onWebSocketPong(quint64 elapsedTime, const QByteArray &payload);
+    void onAudioAvailable();
+    void onWarmSocketTextMessageReceived(const QString &message);
+    void onWarmSocketDisconnected();
+    void onWarmSocketError(QAbstractSocket::SocketError error);
+    void prepareWarmSession();
+    void reconnect();
+    void onDrainingSocketTextMessageReceived(const QString &message);
+    void onRetiringSocketTextMessageReceived(const QString &message);
+    void onRolloverTimeout();
 
 private:
     QWebSocket *m_webSocket;
-    QThread *m_workerThread;
-    QTimer *m_timer;
     AudioBuffer *m_audioBuffer;
     QString m_apiKey;
     bool m_isStreaming;
-    QMutex m_mutex;
-    QByteArray m_lastProcessedData;
+    mutable QMutex m_mutex;
     QString m_sessionId;
     QString m_currentItemId;
 
+    // Send scheduler: audio waits here until a full frame is available
+    QByteArray m_pendingAudio;
+    QElapsedTimer m_pendingAge;
+    int m_frameMs;
+    FrameStats m_frameStats;
+    AudioMessageEncoder m_messageEncoder;
+
+    // Warm session: connected and configured ahead of the next start
+    bool m_warmSessionEnabled;
+    QWebSocket *m_warmSocket;
+    QString m_warmSessionId;
+    bool m_warmReady;
+    QElapsedTimer m_warmAge;
+    QTimer *m_warmRefreshTimer;
+    int m_warmRetryDelayMs;
+    // A rejected key is not retried until it changes
+    bool m_warmAuthFailed;
+    // Probes the link while recordings go to the batch engine
+    QTimer *m_warmPingTimer;
+
+    // Time from start request until audio can flow
+    QElapsedTimer m_startTimer;
+    bool m_coldStartPending;
+    StartStats m_startStats;
+
+    // Replay window: audio sent but not yet transcribed, resent after a drop
+    struct CommittedAudio
+    {
+        QString itemId;
+        QByteArray audio;
+    };
+    QList<CommittedAudio> m_committedAudio;
+    QByteArray m_uncommittedAudio;
+    int m_reconnectAttempts;
+    QElapsedTimer m_reconnectTimer;
+    qint64 m_uncommittedOffset;
+    qint64 m_speechEndOffset;
+
+    // Turn handling; items stay pending until their transcription completes
+    TurnDetection m_turnDetection;
+    bool m_speechActive;
+    bool m_commitPending;
+    QSet<QString> m_pendingItems;
+
+    // Text typed from deltas per item, reconciled against the final transcript
+    QHash<QString, QString> m_typedText;
+    QString m_lastTypedItemId;
+    bool m_liveTypingEnabled;
+
+    // Completed transcripts of the current and the draining utterance
+    quint64 m_utteranceId;
+    QString m_utteranceText;
+    bool m_utteranceFailed;
+    quint64 m_drainingUtteranceId;
+    QString m_drainingUtteranceText;
+    // Hybrid mode reads the buffer without draining it, so the batch
+    // request can use the whole recording
+    bool m_keepRecordedAudio;
+    qint64 m_bufferReadOffset;
+
+    // A stopped session stays open until its last transcript has arrived
+    QWebSocket *m_drainingSocket;
+    bool m_drainingCommitPending;
+    QSet<QString> m_drainingItems;
+
+    // Rollover: a long stream moves to a fresh session before the server's
+    // duration limit, handing over at a commit boundary
+    QElapsedTimer m_sessionAge;
+    QTimer *m_rolloverTimer;
+    bool m_rolloverPending;
+    QByteArray m_lastCommittedTail;
+    QWebSocket *m_retiringSocket;
+    bool m_retiringCommitPending;
+    QSet<QString> m_retiringItems;
+    // The first item of the new session repeats the overlap audio
+    bool m_overlapPending;
+    QString m_overlapItemId;
+    QString m_lastTranscript;
+
+    // Link measurements for the engine selection
+    NetworkQualityEstimator *m_networkEstimator;
+    QTimer *m_pingTimer;
+    QElapsedTimer m_throughputTimer;
+    qint64 m_throughputBytes;
+
+    // Backpressure: lag reporting and the per-utterance batch fallback
+    int m_reportedLagMs;
+    bool m_fallbackActive;
+    QByteArray m_fallbackAudio;
+    // Socket bytes of the burst sent when a session starts: audio captured
+    // before it was ready plus any replay. Not counted as lag.
+    qint64 m_catchUpBytes;
+
+    void beginStreaming(quint64 utteranceId);
+    void endStreaming();
     void setupWebSocket();
-    void sendSessionUpdate();
-    void sendAudioBuffer(const QByteArray &audioData);
-    QByteArray encodeBase64(const QByteArray &data);
+    void attachWebSocket(QWebSocket *socket);
+    void openWebSocket(QWebSocket *socket);
+    void discardWarmSession();
+    void retryWarmSession();
+    bool takeWarmSession();
+    void handleConnectionLoss();
+    void resetReplayWindow();
+    void trimReplayWindow();
+    void releaseCommittedAudio(const QString &itemId);
+    void sendCommit(bool force);
+    void drainSession();
+    void finishDrain();
+    void scheduleRollover();
+    void tryRollover(bool force);
+    void performRollover(bool force);
+    void finishRetiring();
+    int queuedAudioMs() const;
+    void sendCatchUpFrames();
+    void updateNetworkLag();
+    void startBatchFallback();
+    void recordStartLatency(bool warm);
+    void sendPendingFrames(bool flush);
+    void sendSessionUpdate(QWebSocket *socket);
+    void sendAudioBuffer(const char *audioData, qsizetype size);
     QJsonObject createSessionUpdateMessage();
-    void processTranscriptionMessage(const QJsonObject &message);
-    void processCommittedMessage(const QJsonObject &message);
+    bool handleEvent(const RealtimeEventScanner::Event &event);
+    void processTranscriptionMessage(const QString &itemId, const QString &text);
+    void processCompletedMessage(const QString &itemId, const QString &transcript);
+    void appendUtteranceText(QString *utterance, const QString &transcript);
+    void processCommittedMessage(const QString &itemId, const QString &previousItemId);
 };
 
-#endif // OPENAITRANSCRIBER_H
\ No newline at end of file
+#endif // OPENAITRANSCRIBERREALTIME_H
\ No newline at end of file
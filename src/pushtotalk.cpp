@@ -1,5 +1,6 @@
 
 #include "pushtotalk.h"
+#include "x11errortrap.h"
 #include <QDebug>
 
 #include <X11/Xlib.h>
@@ -38,13 +39,19 @@ PushToTalk::~PushToTalk()
     {
         Display *display = (Display *)m_display;
         Window root = (Window)m_root;
-        XUngrabKey(display, AnyKey, AnyModifier, root);
+        {
+            X11ErrorTrap trap(display);
+            XUngrabKey(display, AnyKey, AnyModifier, root);
+        }
         XCloseDisplay(display);
     }
 }
 
 void PushToTalk::setCodeCode(int keyCode)
 {
+    // Another client may hold the key already, which fails with BadAccess
+    X11ErrorTrap trap(m_display);
+
     if (m_keyCode != 0)
         XUngrabKey((Display *)m_display, m_keyCode, AnyModifier, (Window)m_root);
 
@@ -56,6 +63,10 @@ void PushToTalk::setCodeCode(int keyCode)
     XGrabKey((Display *)m_display, keycode, AnyModifier, (Window)m_root, True,
              GrabModeAsync, GrabModeAsync);
     XSelectInput((Display *)m_display, (Window)m_root, KeyPressMask | KeyReleaseMask);
+    if (trap.failed())
+    {
+        qWarning() << "Cannot grab the push-to-talk key; another application may be using it";
+    }
 
     m_isActive = false;
 }
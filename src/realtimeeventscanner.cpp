@@ -0,0 +1,334 @@
+#include "realtimeeventscanner.h"
+
+RealtimeEventScanner::RealtimeEventScanner(QStringView message)
+    : m_text(message), m_pos(0)
+{
+}
+
+bool RealtimeEventScanner::scan(QStringView message, Event *event)
+{
+    RealtimeEventScanner scanner(message);
+    scanner.skipWhitespace();
+    if (!scanner.scanObject(event, false) || event->type.isEmpty())
+    {
+        return false;
+    }
+
+    // Trailing text means a torn or concatenated frame, not one event
+    scanner.skipWhitespace();
+    return scanner.m_pos == scanner.m_text.size();
+}
+
+RealtimeEventScanner::Event RealtimeEventScanner::fromJson(const QJsonObject &message)
+{
+    Event event;
+    event.type = message["type"].toString();
+    event.delta = message["delta"].toString();
+    event.transcript = message["transcript"].toString();
+    event.itemId = message["item_id"].toString();
+    event.previousItemId = message["previous_item_id"].toString();
+    event.errorMessage = message["error"].toObject()["message"].toString();
+    if (message.contains("audio_end_ms"))
+    {
+        event.audioEndMs = message["audio_end_ms"].toInteger();
+    }
+    return event;
+}
+
+void RealtimeEventScanner::skipWhitespace()
+{
+    while (m_pos < m_text.size())
+    {
+        const char16_t c = m_text[m_pos].unicode();
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+        {
+            return;
+        }
+        ++m_pos;
+    }
+}
+
+bool RealtimeEventScanner::scanObject(Event *event, bool errorObject)
+{
+    if (m_pos >= m_text.size() || m_text[m_pos] != u'{')
+    {
+        return false;
+    }
+    ++m_pos;
+
+    skipWhitespace();
+    if (m_pos < m_text.size() && m_text[m_pos] == u'}')
+    {
+        ++m_pos;
+        return true;
+    }
+
+    QString key;
+    while (m_pos < m_text.size())
+    {
+        skipWhitespace();
+        key.clear();
+        if (!scanString(&key))
+        {
+            return false;
+        }
+
+        skipWhitespace();
+        if (m_pos >= m_text.size() || m_text[m_pos] != u':')
+        {
+            return false;
+        }
+        ++m_pos;
+        skipWhitespace();
+        if (m_pos >= m_text.size())
+        {
+            return false;
+        }
+
+        // Pick the wanted fields; anything else is skipped without decoding.
+        // A repeated key replaces the earlier value, as in QJsonDocument, and
+        // a non-string value reads as empty.
+        QString *field = nullptr;
+        if (errorObject)
+        {
+            field = key == u"message" ? &event->errorMessage : nullptr;
+        }
+        else if (key == u"type")
+        {
+            field = &event->type;
+        }
+        else if (key == u"delta")
+        {
+            field = &event->delta;
+        }
+        else if (key == u"transcript")
+        {
+            field = &event->transcript;
+        }
+        else if (key == u"item_id")
+        {
+            field = &event->itemId;
+        }
+        else if (key == u"previous_item_id")
+        {
+            field = &event->previousItemId;
+        }
+
+        bool ok;
+        if (field)
+        {
+            field->clear();
+            ok = m_text[m_pos] == u'"' ? scanString(field) : skipValue();
+        }
+        else if (!errorObject && key == u"audio_end_ms")
+        {
+            ok = scanNumber(&event->audioEndMs);
+        }
+        else if (!errorObject && key == u"error")
+        {
+            event->errorMessage.clear();
+            ok = m_text[m_pos] == u'{' ? scanObject(event, true) : skipValue();
+        }
+        else
+        {
+            ok = skipValue();
+        }
+
+        if (!ok)
+        {
+            return false;
+        }
+
+        skipWhitespace();
+        if (m_pos >= m_text.size())
+        {
+            return false;
+        }
+        if (m_text[m_pos] == u',')
+        {
+            ++m_pos;
+            continue;
+        }
+        if (m_text[m_pos] == u'}')
+        {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    return false;
+}
+
+bool RealtimeEventScanner::scanString(QString *out)
+{
+    if (m_pos >= m_text.size() || m_text[m_pos] != u'"')
+    {
+        return false;
+    }
+    ++m_pos;
+
+    while (m_pos < m_text.size())
+    {
+        // Copy plain runs in one go
+        qsizetype runStart = m_pos;
+        while (m_pos < m_text.size() && m_text[m_pos] != u'"' && m_text[m_pos] != u'\\')
+        {
+            ++m_pos;
+        }
+        if (out && m_pos > runStart)
+        {
+            out->append(m_text.sliced(runStart, m_pos - runStart));
+        }
+
+        if (m_pos >= m_text.size())
+        {
+            return false;
+        }
+
+        if (m_text[m_pos] == u'"')
+        {
+            ++m_pos;
+            return true;
+        }
+
+        // Escape sequence
+        if (m_pos + 1 >= m_text.size())
+        {
+            return false;
+        }
+        const char16_t escaped = m_text[m_pos + 1].unicode();
+        m_pos += 2;
+
+        char16_t decoded;
+        switch (escaped)
+        {
+        case '"':
+        case '\\':
+        case '/':
+            decoded = escaped;
+            break;
+        case 'b':
+            decoded = '\b';
+            break;
+        case 'f':
+            decoded = '\f';
+            break;
+        case 'n':
+            decoded = '\n';
+            break;
+        case 'r':
+            decoded = '\r';
+            break;
+        case 't':
+            decoded = '\t';
+            break;
+        case 'u':
+        {
+            // Surrogate pairs arrive as two escapes and land as two UTF-16 units
+            if (m_pos + 4 > m_text.size())
+            {
+                return false;
+            }
+            bool ok = false;
+            decoded = static_cast<char16_t>(m_text.sliced(m_pos, 4).toUShort(&ok, 16));
+            if (!ok)
+            {
+                return false;
+            }
+            m_pos += 4;
+            break;
+        }
+        default:
+            return false;
+        }
+
+        if (out)
+        {
+            out->append(QChar(decoded));
+        }
+    }
+
+    return false;
+}
+
+bool RealtimeEventScanner::scanNumber(qint64 *out)
+{
+    qsizetype start = m_pos;
+    while (m_pos < m_text.size())
+    {
+        const char16_t c = m_text[m_pos].unicode();
+        if (!((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E'))
+        {
+            break;
+        }
+        ++m_pos;
+    }
+
+    bool ok = false;
+    const double value = m_text.sliced(start, m_pos - start).toDouble(&ok);
+    if (ok)
+    {
+        *out = static_cast<qint64>(value);
+    }
+    return ok;
+}
+
+bool RealtimeEventScanner::skipValue()
+{
+    if (m_pos >= m_text.size())
+    {
+        return false;
+    }
+
+    const QChar first = m_text[m_pos];
+    if (first == u'"')
+    {
+        return scanString(nullptr);
+    }
+
+    if (first == u'{' || first == u'[')
+    {
+        // Track nesting only; strings are skipped so brackets inside them are ignored
+        int depth = 0;
+        while (m_pos < m_text.size())
+        {
+            const QChar c = m_text[m_pos];
+            if (c == u'"')
+            {
+                if (!scanString(nullptr))
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            ++m_pos;
+            if (c == u'{' || c == u'[')
+            {
+                ++depth;
+            }
+            else if (c == u'}' || c == u']')
+            {
+                if (--depth == 0)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Number, true, false or null
+    qsizetype start = m_pos;
+    while (m_pos < m_text.size())
+    {
+        const QChar c = m_text[m_pos];
+        if (c == u',' || c == u'}' || c == u']' || c.isSpace())
+        {
+            break;
+        }
+        ++m_pos;
+    }
+    return m_pos > start;
+}
@@ -0,0 +1,42 @@
+#ifndef REALTIMEEVENTSCANNER_H
+#define REALTIMEEVENTSCANNER_H
+
+#include <QString>
+#include <QStringView>
+#include <QJsonObject>
+
+// Reads the few fields the realtime transcriber needs from a server event
+// without building a JSON document. Only the top-level object and the
+// nested "error" object are looked at; everything else is skipped.
+class RealtimeEventScanner
+{
+public:
+    struct Event
+    {
+        QString type;
+        QString delta;
+        QString transcript;
+        QString itemId;
+        QString previousItemId;
+        QString errorMessage;
+        qint64 audioEndMs = -1;
+    };
+
+    // Returns false on malformed input; callers then fall back to QJsonDocument
+    static bool scan(QStringView message, Event *event);
+    static Event fromJson(const QJsonObject &message);
+
+private:
+    explicit RealtimeEventScanner(QStringView message);
+
+    bool scanObject(Event *event, bool errorObject);
+    bool scanString(QString *out);
+    bool scanNumber(qint64 *out);
+    bool skipValue();
+    void skipWhitespace();
+
+    QStringView m_text;
+    qsizetype m_pos;
+};
+
+#endif // REALTIMEEVENTSCANNER_H
@@ -0,0 +1,144 @@
+#include "transcriptioncache.h"
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QDateTime>
+#include <QDebug>
+
+namespace
+{
+    // Transcripts are small; these caps keep the directory from growing
+    // without limit
+    const int kMaxDiskEntries = 1000;
+    const qint64 kMaxDiskBytes = 2 * 1024 * 1024;
+}
+
+TranscriptionCache::TranscriptionCache(int maxEntries)
+    : m_memory(maxEntries), m_diskCacheEnabled(false)
+{
+    m_diskPath = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/transcripts";
+}
+
+void TranscriptionCache::setDiskCacheEnabled(bool enabled)
+{
+    m_diskCacheEnabled = enabled;
+    if (enabled)
+    {
+        QDir().mkpath(m_diskPath);
+        pruneDisk();
+    }
+    else if (QDir(m_diskPath).exists())
+    {
+        // Transcripts are stored in plain text, so opting out removes them
+        QDir(m_diskPath).removeRecursively();
+        m_stats.diskEntries = 0;
+        m_stats.diskBytes = 0;
+    }
+}
+
+QByteArray TranscriptionCache::audioDigest(const QByteArray &pcm)
+{
+    // MD5 is only used to detect identical audio, not for security
+    return QCryptographicHash::hash(pcm, QCryptographicHash::Md5);
+}
+
+QByteArray TranscriptionCache::key(const QByteArray &audioDigest, const QString &model, const QString &prompt, int sampleRate)
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(audioDigest);
+    hash.addData(model.toUtf8() + '\0');
+    hash.addData(prompt.toUtf8() + '\0');
+
+    // A 16 kHz upload may transcribe differently from the full-rate audio
+    hash.addData(QByteArray::number(sampleRate));
+    return hash.result().toHex();
+}
+
+bool TranscriptionCache::lookup(const QByteArray &key, QString *text)
+{
+    if (QString *cached = m_memory.object(key))
+    {
+        ++m_stats.hits;
+        *text = *cached;
+        return true;
+    }
+
+    if (m_diskCacheEnabled)
+    {
+        QFile file(diskFilePath(key));
+        if (file.open(QIODevice::ReadWrite))
+        {
+            *text = QString::fromUtf8(file.readAll());
+
+            // The modification time is the eviction order
+            file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+            m_memory.insert(key, new QString(*text));
+            ++m_stats.diskHits;
+            return true;
+        }
+    }
+
+    ++m_stats.misses;
+    return false;
+}
+
+void TranscriptionCache::insert(const QByteArray &key, const QString &text)
+{
+    m_memory.insert(key, new QString(text));
+
+    if (m_diskCacheEnabled)
+    {
+        QFile file(diskFilePath(key));
+        if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            file.write(text.toUtf8());
+            file.close();
+            pruneDisk();
+        }
+        else
+        {
+            qWarning() << "Failed to write transcription cache entry:" << file.fileName();
+        }
+    }
+}
+
+TranscriptionCache::Stats TranscriptionCache::stats() const
+{
+    return m_stats;
+}
+
+QString TranscriptionCache::diskFilePath(const QByteArray &key) const
+{
+    return m_diskPath + "/" + QString::fromLatin1(key) + ".txt";
+}
+
+void TranscriptionCache::pruneDisk()
+{
+    // Newest first; whatever no longer fits under the caps is removed
+    QDir dir(m_diskPath);
+    const QFileInfoList files = dir.entryInfoList(QStringList() << "*.txt", QDir::Files, QDir::Time);
+
+    int entries = 0;
+    qint64 bytes = 0;
+    int removed = 0;
+    for (const QFileInfo &info : files)
+    {
+        if (entries < kMaxDiskEntries && bytes + info.size() <= kMaxDiskBytes)
+        {
+            ++entries;
+            bytes += info.size();
+        }
+        else if (QFile::remove(info.filePath()))
+        {
+            ++removed;
+        }
+    }
+
+    m_stats.diskEntries = entries;
+    m_stats.diskBytes = bytes;
+    if (removed > 0)
+    {
+        qDebug() << "Evicted" << removed << "transcripts from the disk cache";
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef TRANSCRIPTIONCACHE_H
+#define TRANSCRIPTIONCACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QString>
+
+// LRU cache of transcripts keyed by a digest of (PCM, model, prompt, upload
+// sample rate), with an opt-in on-disk tier so repeats survive a restart.
+// The disk tier is bounded too: past its entry or byte cap the least
+// recently used files, by modification time, are removed. Not thread-safe;
+// the owner serializes access.
+class TranscriptionCache
+{
+public:
+    struct Stats
+    {
+        int hits = 0;
+        int diskHits = 0;
+        int misses = 0;
+        int diskEntries = 0;
+        qint64 diskBytes = 0;
+    };
+
+    explicit TranscriptionCache(int maxEntries = 256);
+
+    void setDiskCacheEnabled(bool enabled);
+
+    static QByteArray audioDigest(const QByteArray &pcm);
+    static QByteArray key(const QByteArray &audioDigest, const QString &model, const QString &prompt, int sampleRate);
+
+    bool lookup(const QByteArray &key, QString *text);
+    void insert(const QByteArray &key, const QString &text);
+    Stats stats() const;
+
+private:
+    QCache<QByteArray, QString> m_memory;
+    bool m_diskCacheEnabled;
+    QString m_diskPath;
+    Stats m_stats;
+
+    QString diskFilePath(const QByteArray &key) const;
+    void pruneDisk();
+};
+
+#endif // TRANSCRIPTIONCACHE_H
@@ -0,0 +1,295 @@
+#include "typingqueue.h"
+#include "keyboardsimulator.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <utility>
+
+namespace
+{
+    // Bounded so a stalled target cannot make the backlog grow without limit
+    const int kMaxQueuedSegments = 256;
+
+    // Long text is typed in slices so cancellation and progress are prompt
+    const qsizetype kSliceChars = 32;
+
+    // Starting estimates until both injection modes have been measured; a
+    // paste costs the clipboard handoff and the chord
+    const double kDefaultTypeCharsPerSec = 300.0;
+    const double kDefaultPasteMs = 100.0;
+
+    // Short phrases are always typed so the clipboard is left alone
+    const qsizetype kMinPasteChars = 40;
+
+    // Weight of a new sample in the rate averages
+    const double kRateSmoothing = 0.25;
+}
+
+TypingQueue::TypingQueue(QObject *parent)
+    : QObject(parent), m_simulator(new KeyboardSimulator()), m_scheduled(false), m_remainingChars(0), m_generation(0), m_phrase(0), m_droppedPhrase(0), m_activePhrase(0),
+      m_pasteEnabled(false), m_typeCharsPerSec(kDefaultTypeCharsPerSec), m_pasteMs(kDefaultPasteMs)
+{
+    // Moves to the typing thread together with this object
+    m_simulator->setParent(this);
+}
+
+TypingQueue::~TypingQueue()
+{
+}
+
+bool TypingQueue::isAvailable() const
+{
+    return m_simulator->isAvailable();
+}
+
+void TypingQueue::typeText(const QString &text)
+{
+    enqueue({Kind::Type, text, QString()});
+}
+
+void TypingQueue::appendText(const QString &text)
+{
+    enqueue({Kind::Append, text, QString()});
+}
+
+void TypingQueue::replaceText(const QString &oldText, const QString &newText)
+{
+    enqueue({Kind::Replace, newText, oldText});
+}
+
+void TypingQueue::cancel()
+{
+    int dropped;
+    {
+        QMutexLocker locker(&m_mutex);
+        // Only a phrase that loses queued or unfinished text is cut; a
+        // finished one may still be continued, e.g. by a stream that drains
+        // after a new recording started
+        bool cut = m_activePhrase == m_phrase;
+        for (const Segment &segment : std::as_const(m_queue))
+        {
+            cut = cut || segment.phrase == m_phrase;
+        }
+        if (cut)
+        {
+            m_droppedPhrase = m_phrase;
+        }
+
+        m_generation.fetchAndAddOrdered(1);
+        m_queue.clear();
+        dropped = m_remainingChars;
+        m_remainingChars = 0;
+    }
+
+    if (dropped > 0)
+    {
+        qDebug() << "Cancelled typing of" << dropped << "characters";
+        emit progressChanged(0);
+    }
+}
+
+int TypingQueue::pendingChars() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_remainingChars;
+}
+
+void TypingQueue::setPasteEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pasteEnabled = enabled;
+}
+
+void TypingQueue::enqueue(Segment segment)
+{
+    int remaining;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (segment.kind == Kind::Type)
+        {
+            ++m_phrase;
+        }
+        segment.phrase = m_phrase;
+
+        // Continuing a cut phrase would append to, or erase, text that was
+        // never typed
+        if (segment.kind != Kind::Type && segment.phrase == m_droppedPhrase)
+        {
+            locker.unlock();
+            qDebug() << "Dropping continuation of a cancelled phrase:" << segment.text;
+            return;
+        }
+
+        if (m_queue.size() >= kMaxQueuedSegments)
+        {
+            m_droppedPhrase = segment.phrase;
+            locker.unlock();
+            qWarning() << "Typing queue is full, dropping:" << segment.text;
+            emit typingFailed("Typing queue is full");
+            return;
+        }
+
+        segment.generation = m_generation.loadAcquire();
+        m_remainingChars += segment.text.size();
+        remaining = m_remainingChars;
+        m_queue.append(segment);
+
+        // One queued drain call serves every segment added before it runs
+        if (!m_scheduled)
+        {
+            m_scheduled = true;
+            QMetaObject::invokeMethod(this, [this]()
+                                      { drain(); }, Qt::QueuedConnection);
+        }
+    }
+
+    emit progressChanged(remaining);
+}
+
+void TypingQueue::drain()
+{
+    for (;;)
+    {
+        Segment segment;
+        {
+            QMutexLocker locker(&m_mutex);
+            m_activePhrase = 0;
+            if (m_queue.isEmpty())
+            {
+                m_scheduled = false;
+                return;
+            }
+            segment = m_queue.takeFirst();
+            m_activePhrase = segment.phrase;
+        }
+
+        if (!typeSegment(segment))
+        {
+            qWarning() << "Failed to type transcription";
+            emit typingFailed("Failed to type transcription");
+        }
+    }
+}
+
+bool TypingQueue::typeSegment(const Segment &segment)
+{
+    if (isCancelled(segment))
+    {
+        return true;
+    }
+
+    // A revision erases and retypes as one step so the text stays consistent
+    if (segment.kind == Kind::Replace)
+    {
+        bool ok = m_simulator->replaceText(segment.oldText, segment.text);
+        consume(segment, segment.text.size());
+        return ok;
+    }
+
+    if (shouldPaste(segment))
+    {
+        return pasteSegment(segment);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const QString &text = segment.text;
+    qsizetype offset = 0;
+    while (offset < text.size())
+    {
+        if (isCancelled(segment))
+        {
+            return true;
+        }
+
+        // Never split a surrogate pair
+        qsizetype length = qMin(kSliceChars, text.size() - offset);
+        if (offset + length < text.size() && text.at(offset + length - 1).isHighSurrogate())
+        {
+            ++length;
+        }
+
+        // Only the first slice of a new phrase gets the separating space
+        const QString slice = text.mid(offset, length);
+        bool ok = segment.kind == Kind::Type && offset == 0 ? m_simulator->typeText(slice) : m_simulator->appendText(slice);
+        offset += length;
+        consume(segment, length);
+
+        if (!ok)
+        {
+            consume(segment, text.size() - offset);
+            return false;
+        }
+    }
+
+    // Per-character delays dominate, so longer phrases give steadier samples
+    const qint64 elapsedMs = timer.elapsed();
+    if (text.size() >= kSliceChars && elapsedMs > 0)
+    {
+        const double charsPerSec = text.size() * 1000.0 / elapsedMs;
+        m_typeCharsPerSec += kRateSmoothing * (charsPerSec - m_typeCharsPerSec);
+        qDebug() << "Typed" << text.size() << "characters at" << qRound(charsPerSec) << "chars/s";
+    }
+
+    return true;
+}
+
+bool TypingQueue::pasteSegment(const Segment &segment)
+{
+    // The settle time before the clipboard is restored is not counted; the
+    // text is in the target once the chord has gone out
+    qint64 handoffMs = 0;
+    bool ok = m_simulator->pasteText(segment.text, segment.kind == Kind::Append, [this, &segment]()
+                                     { return isCancelled(segment); }, &handoffMs);
+    consume(segment, segment.text.size());
+    if (!ok)
+    {
+        return isCancelled(segment);
+    }
+
+    const qint64 elapsedMs = qMax<qint64>(handoffMs, 1);
+    m_pasteMs += kRateSmoothing * (elapsedMs - m_pasteMs);
+    qDebug() << "Pasted" << segment.text.size() << "characters at" << qRound(segment.text.size() * 1000.0 / elapsedMs)
+             << "chars/s; typing runs at" << qRound(m_typeCharsPerSec) << "chars/s, pasting from" << pasteThreshold() << "characters";
+    return true;
+}
+
+bool TypingQueue::shouldPaste(const Segment &segment) const
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_pasteEnabled)
+        {
+            return false;
+        }
+    }
+
+    return segment.text.size() >= pasteThreshold();
+}
+
+qsizetype TypingQueue::pasteThreshold() const
+{
+    // The length at which typing takes as long as one paste round trip
+    return qMax(kMinPasteChars, qsizetype(m_typeCharsPerSec * m_pasteMs / 1000.0));
+}
+
+bool TypingQueue::isCancelled(const Segment &segment) const
+{
+    return segment.generation != m_generation.loadAcquire();
+}
+
+void TypingQueue::consume(const Segment &segment, int chars)
+{
+    int remaining;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (isCancelled(segment) || chars <= 0)
+        {
+            return;
+        }
+        m_remainingChars -= chars;
+        remaining = m_remainingChars;
+    }
+
+    emit progressChanged(remaining);
+}
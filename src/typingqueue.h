@@ -0,0 +1,85 @@
+#ifndef TYPINGQUEUE_H
+#define TYPINGQUEUE_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QMutex>
+#include <QAtomicInteger>
+
+class KeyboardSimulator;
+
+// Types text on the thread this object lives on, so the caller never waits
+// for keystroke synthesis. Segments are typed in the order they were queued;
+// cancel() drops everything queued and stops the current segment at the next
+// slice. A phrase starts with typeText(); appends and replacements continue
+// the latest phrase. Once part of a phrase has been dropped, by cancel() or a
+// full queue, the rest of it is dropped too, since the transcriber's idea of
+// what was typed no longer matches the screen. A phrase that was completely
+// typed when cancel() ran is not affected. With pasting enabled, phrases long
+// enough that typing them would take longer than a clipboard paste are pasted
+// instead. The public methods are thread-safe.
+class TypingQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TypingQueue(QObject *parent = nullptr);
+    ~TypingQueue();
+
+    bool isAvailable() const;
+    void typeText(const QString &text);
+    void appendText(const QString &text);
+    void replaceText(const QString &oldText, const QString &newText);
+    void cancel();
+    int pendingChars() const;
+    void setPasteEnabled(bool enabled);
+
+signals:
+    // Characters still to be typed; 0 once the queue has drained
+    void progressChanged(int remainingChars);
+    void typingFailed(const QString &error);
+
+private:
+    enum class Kind
+    {
+        Type,
+        Append,
+        Replace
+    };
+
+    struct Segment
+    {
+        Kind kind;
+        QString text;
+        QString oldText;
+        quint64 generation = 0;
+        quint64 phrase = 0;
+    };
+
+    KeyboardSimulator *m_simulator;
+    mutable QMutex m_mutex;
+    QList<Segment> m_queue;
+    bool m_scheduled;
+    int m_remainingChars;
+    QAtomicInteger<quint64> m_generation;
+    quint64 m_phrase;
+    quint64 m_droppedPhrase; // 0 while every phrase is intact
+    quint64 m_activePhrase;  // Phrase of the segment being typed, or 0
+    bool m_pasteEnabled;
+
+    // Measured on the typing thread only
+    double m_typeCharsPerSec;
+    double m_pasteMs;
+
+    void enqueue(Segment segment);
+    void drain();
+    bool typeSegment(const Segment &segment);
+    bool pasteSegment(const Segment &segment);
+    bool shouldPaste(const Segment &segment) const;
+    qsizetype pasteThreshold() const;
+    bool isCancelled(const Segment &segment) const;
+    void consume(const Segment &segment, int chars);
+};
+
+#endif // TYPINGQUEUE_H
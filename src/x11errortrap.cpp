@@ -0,0 +1,62 @@
+#include "x11errortrap.h"
+#include <QDebug>
+#include <QMutex>
+#include <atomic>
+
+#include <X11/Xlib.h>
+
+namespace
+{
+    // Held from the constructor to the destructor of a trap
+    QMutex g_trapMutex;
+
+    // Written under the lock, read by the handler on whichever thread
+    // processes the error
+    std::atomic<Display *> g_trapDisplay{nullptr};
+    std::atomic<XErrorHandler> g_previousHandler{nullptr};
+    std::atomic<int> g_errorCode{0};
+
+    int recordError(Display *display, XErrorEvent *event)
+    {
+        if (display != g_trapDisplay.load())
+        {
+            XErrorHandler previous = g_previousHandler.load();
+            return previous ? previous(display, event) : 0;
+        }
+
+        char message[128];
+        XGetErrorText(display, event->error_code, message, sizeof(message));
+        qWarning() << "X error:" << message << "request" << event->request_code;
+        g_errorCode.store(event->error_code);
+        return 0;
+    }
+}
+
+X11ErrorTrap::X11ErrorTrap(void *display)
+    : m_display(display)
+{
+    g_trapMutex.lock();
+
+    // Errors of earlier requests belong to whoever sent them
+    XSync((Display *)m_display, False);
+
+    g_errorCode.store(0);
+    g_trapDisplay.store((Display *)m_display);
+    g_previousHandler.store(XSetErrorHandler(recordError));
+}
+
+X11ErrorTrap::~X11ErrorTrap()
+{
+    // Errors arrive asynchronously, so collect them before letting go
+    XSync((Display *)m_display, False);
+    XSetErrorHandler(g_previousHandler.load());
+    g_trapDisplay.store(nullptr);
+
+    g_trapMutex.unlock();
+}
+
+bool X11ErrorTrap::failed()
+{
+    XSync((Display *)m_display, False);
+    return g_errorCode.load() != 0;
+}
@@ -0,0 +1,22 @@
+#ifndef X11ERRORTRAP_H
+#define X11ERRORTRAP_H
+
+// Catches the X errors of one display connection while it lives, in place of
+// Xlib's default handler, which exits the process. The handler is process
+// wide, so traps are serialized by a lock shared by every thread that uses
+// one, and errors of other connections are passed on to the previous
+// handler. Requires XInitThreads(), which main() calls.
+class X11ErrorTrap
+{
+public:
+    explicit X11ErrorTrap(void *display);
+    ~X11ErrorTrap();
+
+    // Syncs with the server, then reports whether any request failed
+    bool failed();
+
+private:
+    void *m_display; // X11 Display pointer
+};
+
+#endif // X11ERRORTRAP_H
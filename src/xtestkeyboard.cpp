@@ -0,0 +1,473 @@
+#include "xtestkeyboard.h"
+#include "x11errortrap.h"
+#include <QDebug>
+#include <QThread>
+#include <algorithm>
+
+#include <X11/Xlib.h>
+#include <X11/XKBlib.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XTest.h>
+
+namespace
+{
+    // Short pause between characters; some clients drop keys sent back to back
+    const unsigned long kKeyDelayUs = 1000;
+
+    // Upper bound on keycodes held for characters missing from the layout
+    const int kMaxSpareKeys = 32;
+
+    KeySym keysymForCodePoint(char32_t codePoint)
+    {
+        switch (codePoint)
+        {
+        case '\n':
+            return XK_Return;
+        case '\t':
+            return XK_Tab;
+        default:
+            break;
+        }
+
+        // Latin-1 keysyms equal their code points; everything else uses the
+        // Unicode keysym range
+        if ((codePoint >= 0x20 && codePoint <= 0x7e) || (codePoint >= 0xa0 && codePoint <= 0xff))
+        {
+            return codePoint;
+        }
+        return 0x01000000 | codePoint;
+    }
+}
+
+XTestKeyboard::XTestKeyboard()
+    : m_display(nullptr), m_hasXkb(false), m_group(0), m_shiftKeycode(0), m_backSpaceKeycode(0), m_useCounter(0)
+{
+    Display *display = XOpenDisplay(nullptr);
+    if (!display)
+    {
+        qWarning() << "Cannot open X display for XTest";
+        return;
+    }
+
+    int eventBase, errorBase, major, minor;
+    if (!XTestQueryExtension(display, &eventBase, &errorBase, &major, &minor))
+    {
+        qWarning() << "XTest extension not available";
+        XCloseDisplay(display);
+        return;
+    }
+
+    // Without XKB only the first group is used, as core clients do
+    int xkbOpcode, xkbEventBase, xkbErrorBase;
+    int xkbMajor = XkbMajorVersion, xkbMinor = XkbMinorVersion;
+    m_hasXkb = XkbQueryExtension(display, &xkbOpcode, &xkbEventBase, &xkbErrorBase, &xkbMajor, &xkbMinor);
+
+    m_display = display;
+    refreshKeymap();
+}
+
+XTestKeyboard::~XTestKeyboard()
+{
+    if (!m_display)
+    {
+        return;
+    }
+
+    // Hand the spare keys back unbound
+    QList<int> bound;
+    for (int index = 0; index < m_spareKeys.size(); ++index)
+    {
+        if (m_spareKeys[index].keysym)
+        {
+            m_spareKeys[index].keysym = 0;
+            bound.append(index);
+        }
+    }
+
+    {
+        X11ErrorTrap trap((Display *)m_display);
+        writeSpareKeys(bound);
+    }
+
+    XCloseDisplay((Display *)m_display);
+}
+
+bool XTestKeyboard::isAvailable() const
+{
+    return m_display != nullptr;
+}
+
+void XTestKeyboard::refreshKeymap()
+{
+    Display *display = (Display *)m_display;
+
+    m_group = currentGroup();
+    m_shiftKeycode = XKeysymToKeycode(display, XK_Shift_L);
+    m_backSpaceKeycode = XKeysymToKeycode(display, XK_BackSpace);
+
+    int minKeycode, maxKeycode, keysymsPerKeycode;
+    XDisplayKeycodes(display, &minKeycode, &maxKeycode);
+    KeySym *keysyms = XGetKeyboardMapping(display, minKeycode, maxKeycode - minKeycode + 1, &keysymsPerKeycode);
+    if (!keysyms)
+    {
+        return;
+    }
+
+    QHash<int, SpareKey> previous;
+    for (const SpareKey &key : m_spareKeys)
+    {
+        previous.insert(key.keycode, key);
+    }
+
+    // Unshifted and shifted levels of the active group only; other levels
+    // need modifiers that vary between layouts, so those characters go
+    // through the spare keys. Without a Shift key only the first level is
+    // reachable.
+    const int levels = m_shiftKeycode ? 2 : 1;
+    m_keymap.clear();
+    m_spareKeys.clear();
+    m_spareIndex.clear();
+    QList<quint8> unusedKeycodes;
+    for (int keycode = minKeycode; keycode <= maxKeycode; ++keycode)
+    {
+        const KeySym *syms = keysyms + (keycode - minKeycode) * keysymsPerKeycode;
+
+        // Keep cached bindings the server still holds. A spare key has one
+        // group, which XKB falls back to whichever group is active.
+        auto it = previous.constFind(keycode);
+        if (it != previous.constEnd() && it->keysym && syms[0] == it->keysym)
+        {
+            m_spareIndex.insert(it->keysym, m_spareKeys.size());
+            m_spareKeys.append(*it);
+            continue;
+        }
+
+        bool unused = true;
+        for (int level = 0; level < keysymsPerKeycode; ++level)
+        {
+            unused = unused && syms[level] == NoSymbol;
+        }
+        if (unused)
+        {
+            unusedKeycodes.append(keycode);
+            continue;
+        }
+
+        for (int level = levels - 1; level >= 0; --level)
+        {
+            KeySym sym = NoSymbol;
+            if (m_hasXkb)
+            {
+                sym = XkbKeycodeToKeysym(display, keycode, m_group, level);
+            }
+            else if (level < keysymsPerKeycode)
+            {
+                sym = syms[level];
+            }
+
+            if (sym != NoSymbol && (level == 0 || !m_keymap.contains(sym)))
+            {
+                m_keymap.insert(sym, {static_cast<quint8>(keycode), level == 1});
+            }
+        }
+    }
+
+    XFree(keysyms);
+
+    // Leave one unused keycode for other tools that remap a scratch key
+    if (!unusedKeycodes.isEmpty())
+    {
+        unusedKeycodes.removeLast();
+    }
+    for (quint8 keycode : unusedKeycodes)
+    {
+        if (m_spareKeys.size() >= kMaxSpareKeys)
+        {
+            break;
+        }
+        m_spareKeys.append({keycode, 0, 0});
+    }
+}
+
+void XTestKeyboard::processMappingEvents()
+{
+    Display *display = (Display *)m_display;
+
+    // No input is selected on this connection, so MappingNotify is the only
+    // event that arrives here; X errors go to the error handler instead
+    bool stale = false;
+    while (XPending(display))
+    {
+        XEvent event;
+        XNextEvent(display, &event);
+        if (event.type != MappingNotify)
+        {
+            continue;
+        }
+
+        XRefreshKeyboardMapping(&event.xmapping);
+
+        // Changes to the spare keys are our own and already accounted for
+        stale = stale || event.xmapping.request != MappingKeyboard ||
+                !ownsKeycodes(event.xmapping.first_keycode, event.xmapping.count);
+    }
+
+    // Switching layouts changes the XKB group without a MappingNotify
+    stale = stale || currentGroup() != m_group;
+
+    if (stale)
+    {
+        refreshKeymap();
+    }
+}
+
+int XTestKeyboard::currentGroup() const
+{
+    if (!m_hasXkb)
+    {
+        return 0;
+    }
+
+    XkbStateRec state;
+    if (XkbGetState((Display *)m_display, XkbUseCoreKbd, &state) != Success)
+    {
+        return 0;
+    }
+    return state.group;
+}
+
+bool XTestKeyboard::ownsKeycodes(int first, int count) const
+{
+    for (int keycode = first; keycode < first + count; ++keycode)
+    {
+        bool owned = false;
+        for (const SpareKey &key : m_spareKeys)
+        {
+            owned = owned || key.keycode == keycode;
+        }
+        if (!owned)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool XTestKeyboard::typeText(const QString &text)
+{
+    if (!m_display)
+    {
+        return false;
+    }
+
+    X11ErrorTrap trap((Display *)m_display);
+
+    // The layout may have changed since the last call
+    processMappingEvents();
+
+    const QList<uint> codePoints = text.toUcs4();
+    QList<quint32> keysyms;
+    keysyms.reserve(codePoints.size());
+    for (uint codePoint : codePoints)
+    {
+        keysyms.append(keysymForCodePoint(codePoint));
+    }
+
+    bool ok = true;
+    qsizetype start = 0;
+    while (start < keysyms.size())
+    {
+        // Bind every missing character of the next run in one remap, then
+        // type the run
+        const qsizetype end = bindSpareKeys(keysyms, start);
+        for (qsizetype i = start; i < end; ++i)
+        {
+            auto mapped = m_keymap.constFind(keysyms[i]);
+            auto spare = m_spareIndex.constFind(keysyms[i]);
+            if (mapped != m_keymap.constEnd())
+            {
+                tap(mapped->keycode, mapped->shift);
+            }
+            else if (spare != m_spareIndex.constEnd())
+            {
+                tap(m_spareKeys[*spare].keycode, false);
+            }
+            else
+            {
+                const char32_t codePoint = codePoints[i];
+                qWarning() << "No keycode available for character" << QString::fromUcs4(&codePoint, 1);
+                ok = false;
+            }
+        }
+        start = end;
+    }
+
+    if (trap.failed())
+    {
+        // A remap may have been rejected, so read back what the server holds
+        refreshKeymap();
+        ok = false;
+    }
+    return ok;
+}
+
+qsizetype XTestKeyboard::bindSpareKeys(const QList<quint32> &keysyms, qsizetype start)
+{
+    // Keys bound for this run must not be evicted before they are typed
+    QList<int> pinned;
+    QList<int> changed;
+
+    qsizetype end = start;
+    for (; end < keysyms.size(); ++end)
+    {
+        const quint32 keysym = keysyms[end];
+        if (m_keymap.contains(keysym))
+        {
+            continue;
+        }
+
+        auto it = m_spareIndex.constFind(keysym);
+        if (it != m_spareIndex.constEnd())
+        {
+            m_spareKeys[*it].lastUsed = ++m_useCounter;
+            pinned.append(*it);
+            continue;
+        }
+
+        const int index = leastRecentlyUsed(pinned);
+        if (index < 0)
+        {
+            // Without spare keys the character is reported when typed;
+            // otherwise the run ends here and the next one reuses the keys
+            if (m_spareKeys.isEmpty())
+            {
+                continue;
+            }
+            break;
+        }
+
+        SpareKey &key = m_spareKeys[index];
+        if (key.keysym)
+        {
+            m_spareIndex.remove(key.keysym);
+        }
+        key.keysym = keysym;
+        key.lastUsed = ++m_useCounter;
+        m_spareIndex.insert(keysym, index);
+        pinned.append(index);
+        changed.append(index);
+    }
+
+    writeSpareKeys(changed);
+    return end;
+}
+
+int XTestKeyboard::leastRecentlyUsed(const QList<int> &pinned) const
+{
+    // Unbound keys have never been used, so they are taken first
+    int result = -1;
+    for (int index = 0; index < m_spareKeys.size(); ++index)
+    {
+        if (!pinned.contains(index) && (result < 0 || m_spareKeys[index].lastUsed < m_spareKeys[result].lastUsed))
+        {
+            result = index;
+        }
+    }
+    return result;
+}
+
+void XTestKeyboard::writeSpareKeys(const QList<int> &indexes)
+{
+    if (indexes.isEmpty())
+    {
+        return;
+    }
+
+    Display *display = (Display *)m_display;
+
+    QList<SpareKey> keys;
+    for (int index : indexes)
+    {
+        keys.append(m_spareKeys[index]);
+    }
+    std::sort(keys.begin(), keys.end(), [](const SpareKey &a, const SpareKey &b)
+              { return a.keycode < b.keycode; });
+
+    // Every change notifies all clients, so adjacent keycodes go in one request
+    qsizetype first = 0;
+    while (first < keys.size())
+    {
+        qsizetype last = first;
+        while (last + 1 < keys.size() && keys[last + 1].keycode == keys[last].keycode + 1)
+        {
+            ++last;
+        }
+
+        QList<KeySym> syms;
+        for (qsizetype i = first; i <= last; ++i)
+        {
+            // An unbound key goes back to NoSymbol, which is 0
+            syms << keys[i].keysym << keys[i].keysym;
+        }
+        XChangeKeyboardMapping(display, keys[first].keycode, 2, syms.data(), last - first + 1);
+        first = last + 1;
+    }
+
+    // Clients must see the new mapping before the key events
+    XSync(display, False);
+}
+
+bool XTestKeyboard::eraseCharacters(qsizetype count)
+{
+    if (!m_display || !m_backSpaceKeycode)
+    {
+        return false;
+    }
+
+    X11ErrorTrap trap((Display *)m_display);
+    for (qsizetype i = 0; i < count; ++i)
+    {
+        tap(m_backSpaceKeycode, false);
+    }
+
+    return !trap.failed();
+}
+
+bool XTestKeyboard::sendPasteChord()
+{
+    if (!m_display)
+    {
+        return false;
+    }
+
+    Display *display = (Display *)m_display;
+    const quint8 insertKeycode = XKeysymToKeycode(display, XK_Insert);
+    if (!insertKeycode || !m_shiftKeycode)
+    {
+        return false;
+    }
+
+    // Shift+Insert pastes in terminals as well as in GUI toolkits
+    X11ErrorTrap trap(display);
+    tap(insertKeycode, true);
+    return !trap.failed();
+}
+
+void XTestKeyboard::tap(quint8 keycode, bool shift)
+{
+    Display *display = (Display *)m_display;
+
+    if (shift)
+    {
+        XTestFakeKeyEvent(display, m_shiftKeycode, True, CurrentTime);
+    }
+    XTestFakeKeyEvent(display, keycode, True, CurrentTime);
+    XTestFakeKeyEvent(display, keycode, False, CurrentTime);
+    if (shift)
+    {
+        XTestFakeKeyEvent(display, m_shiftKeycode, False, CurrentTime);
+    }
+
+    XFlush(display);
+    QThread::usleep(kKeyDelayUs);
+}
@@ -0,0 +1,59 @@
+#ifndef XTESTKEYBOARD_H
+#define XTESTKEYBOARD_H
+
+#include <QString>
+#include <QHash>
+#include <QList>
+
+// Synthesizes key events through the XTest extension over a display
+// connection that stays open, so typing does not spawn a process per call.
+// Characters missing from the keyboard layout are bound to a pool of spare
+// keycodes that keeps recently used characters mapped between calls, so
+// accented and CJK text costs a remap only on first use. Not thread-safe;
+// use it from one thread at a time.
+class XTestKeyboard
+{
+public:
+    XTestKeyboard();
+    ~XTestKeyboard();
+
+    bool isAvailable() const;
+    bool typeText(const QString &text);
+    bool eraseCharacters(qsizetype count);
+    bool sendPasteChord();
+
+private:
+    struct KeyMapping
+    {
+        quint8 keycode;
+        bool shift;
+    };
+
+    struct SpareKey
+    {
+        quint8 keycode;
+        quint32 keysym; // 0 while unbound
+        quint64 lastUsed;
+    };
+
+    void *m_display; // X11 Display pointer
+    bool m_hasXkb;
+    int m_group; // XKB group the keymap was read for
+    quint8 m_shiftKeycode;
+    quint8 m_backSpaceKeycode;
+    QHash<quint32, KeyMapping> m_keymap;
+    QList<SpareKey> m_spareKeys;
+    QHash<quint32, int> m_spareIndex; // keysym -> index in m_spareKeys
+    quint64 m_useCounter;
+
+    void refreshKeymap();
+    void processMappingEvents();
+    int currentGroup() const;
+    bool ownsKeycodes(int first, int count) const;
+    qsizetype bindSpareKeys(const QList<quint32> &keysyms, qsizetype start);
+    int leastRecentlyUsed(const QList<int> &pinned) const;
+    void writeSpareKeys(const QList<int> &indexes);
+    void tap(quint8 keycode, bool shift);
+};
+
+#endif // XTESTKEYBOARD_H
@@ -0,0 +1,187 @@
+#include <QCoreApplication>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QDebug>
+#include "src/audiomessageencoder.h"
+
+// Checks the base64 kernel against Qt's scalar encoder on lengths around the
+// 12-byte vector step and its 16-byte load window, then times both, and the
+// whole per-frame message build against the QJsonDocument path it replaced.
+
+static int failures = 0;
+
+static void check(bool condition, const QString &what)
+{
+    if (!condition)
+    {
+        qWarning() << "FAIL:" << what;
+        ++failures;
+    }
+}
+
+static QByteArray randomBytes(QRandomGenerator *random, qsizetype size)
+{
+    QByteArray bytes(size, Qt::Uninitialized);
+    for (qsizetype i = 0; i < size; ++i)
+    {
+        bytes[i] = static_cast<char>(random->bounded(256));
+    }
+    return bytes;
+}
+
+static QByteArray encode(const QByteArray &input)
+{
+    QByteArray out(AudioMessageEncoder::base64Size(input.size()), Qt::Uninitialized);
+    qsizetype written = AudioMessageEncoder::base64Encode(reinterpret_cast<const uchar *>(input.constData()), input.size(), out.data());
+    out.truncate(written);
+    return out;
+}
+
+static void testLengths()
+{
+    QRandomGenerator random(36);
+
+    // Every tail length after 0 to 8 vector iterations, plus odd sizes
+    for (qsizetype size = 0; size <= 120; ++size)
+    {
+        const QByteArray input = randomBytes(&random, size);
+        check(encode(input) == input.toBase64(), QString("length %1").arg(size));
+    }
+
+    for (qsizetype size : {959, 960, 961, 1919, 4801})
+    {
+        const QByteArray input = randomBytes(&random, size);
+        check(encode(input) == input.toBase64(), QString("length %1").arg(size));
+    }
+
+    // Byte values that map to the edges of each alphabet range
+    QByteArray edges;
+    for (int i = 0; i < 256; ++i)
+    {
+        edges.append(static_cast<char>(i));
+        edges.append(static_cast<char>(255 - i));
+    }
+    check(encode(edges) == edges.toBase64(), "all byte values");
+}
+
+static void testUnalignedInput()
+{
+    // The kernel loads 16 bytes at a time and must not depend on alignment
+    QRandomGenerator random(37);
+    const QByteArray storage = randomBytes(&random, 256);
+    for (int offset = 0; offset < 16; ++offset)
+    {
+        const QByteArray input = storage.mid(offset, 100);
+        check(encode(input) == input.toBase64(), QString("offset %1").arg(offset));
+    }
+}
+
+static void testAppendMessage()
+{
+    QRandomGenerator random(38);
+    AudioMessageEncoder encoder;
+
+    // The reused buffer must shrink back for a shorter frame
+    for (qsizetype size : {1920, 7, 960, 0})
+    {
+        const QByteArray pcm = randomBytes(&random, size);
+        const QByteArray expected = "{\"type\":\"input_audio_buffer.append\",\"audio\":\"" + pcm.toBase64() + "\"}";
+        check(encoder.encodeAppend(pcm.constData(), pcm.size()) == expected, QString("append message of %1 bytes").arg(size));
+    }
+}
+
+static void benchmark()
+{
+    // One second of 24 kHz PCM16, the size of a large realtime frame
+    QRandomGenerator random(39);
+    const QByteArray pcm = randomBytes(&random, 48000);
+    const int iterations = 2000;
+
+    QElapsedTimer timer;
+    timer.start();
+    qsizetype total = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+        total += encode(pcm).size();
+    }
+    const qint64 encoderNs = qMax<qint64>(timer.nsecsElapsed(), 1);
+
+    timer.restart();
+    for (int i = 0; i < iterations; ++i)
+    {
+        total += pcm.toBase64().size();
+    }
+    const qint64 qtNs = qMax<qint64>(timer.nsecsElapsed(), 1);
+
+    const double megabytes = double(pcm.size()) * iterations / (1024 * 1024);
+    qInfo() << "base64Encode:" << qRound(megabytes * 1e9 / encoderNs) << "MB/s,"
+            << "QByteArray::toBase64:" << qRound(megabytes * 1e9 / qtNs) << "MB/s"
+            << "(" << total << "bytes )";
+}
+
+static void benchmarkMessage()
+{
+    // A minute of 40 ms frames, as handed to sendTextMessage()
+    QRandomGenerator random(40);
+    const QByteArray pcm = randomBytes(&random, 60 * 48000);
+    const qsizetype frameBytes = 1920;
+    const int rounds = 20;
+    AudioMessageEncoder encoder;
+
+    QElapsedTimer timer;
+    timer.start();
+    qsizetype total = 0;
+    for (int round = 0; round < rounds; ++round)
+    {
+        for (qsizetype offset = 0; offset + frameBytes <= pcm.size(); offset += frameBytes)
+        {
+            const QString message = QString::fromLatin1(encoder.encodeAppend(pcm.constData() + offset, frameBytes));
+            total += message.size();
+        }
+    }
+    const qint64 encoderNs = qMax<qint64>(timer.nsecsElapsed(), 1);
+
+    // The frame copy, base64, JSON object and compact document it replaced
+    timer.restart();
+    for (int round = 0; round < rounds; ++round)
+    {
+        for (qsizetype offset = 0; offset + frameBytes <= pcm.size(); offset += frameBytes)
+        {
+            const QByteArray frame = pcm.mid(offset, frameBytes);
+            QJsonObject audioMessage;
+            audioMessage["type"] = "input_audio_buffer.append";
+            audioMessage["audio"] = QString::fromUtf8(frame.toBase64());
+            const QString message = QJsonDocument(audioMessage).toJson(QJsonDocument::Compact);
+            total += message.size();
+        }
+    }
+    const qint64 jsonNs = qMax<qint64>(timer.nsecsElapsed(), 1);
+
+    const qint64 frames = pcm.size() / frameBytes * rounds;
+    qInfo() << "encodeAppend message:" << encoderNs / frames << "ns/frame,"
+            << "QJsonDocument message:" << jsonNs / frames << "ns/frame"
+            << "(" << total << "characters )";
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    testLengths();
+    testUnalignedInput();
+    testAppendMessage();
+    benchmark();
+    benchmarkMessage();
+
+    if (failures > 0)
+    {
+        qWarning() << failures << "checks failed";
+        return 1;
+    }
+
+    qInfo() << "All audio message encoder checks passed";
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QDebug>
+#include "src/realtimeeventscanner.h"
+
+// Feeds the field scanner whole, torn and mutated server events and checks
+// it against QJsonDocument, which the transcriber falls back to, then times
+// both on a stream of deltas.
+
+static int failures = 0;
+
+static void check(bool condition, const QString &what)
+{
+    if (!condition)
+    {
+        qWarning() << "FAIL:" << what;
+        ++failures;
+    }
+}
+
+static bool sameEvent(const RealtimeEventScanner::Event &a, const RealtimeEventScanner::Event &b)
+{
+    return a.type == b.type && a.delta == b.delta && a.transcript == b.transcript && a.itemId == b.itemId &&
+           a.previousItemId == b.previousItemId && a.errorMessage == b.errorMessage && a.audioEndMs == b.audioEndMs;
+}
+
+// Seed corpus: hand-written in the shapes of the events the transcriber
+// handles, plus nesting, escapes, formatting and repeated keys the scanner
+// has to get right
+static QStringList corpus()
+{
+    return {
+        R"({"type":"conversation.item.input_audio_transcription.delta","event_id":"event_1","item_id":"item_1","content_index":0,"delta":"Hello"})",
+        R"({"type":"conversation.item.input_audio_transcription.completed","item_id":"item_1","content_index":0,"transcript":"Say \"hi\"\\n café 🍍 \/ \t done"})",
+        R"({"type":"input_audio_buffer.speech_stopped","event_id":"event_2","audio_end_ms":1234,"item_id":"item_2"})",
+        R"({"type":"input_audio_buffer.committed","event_id":"event_3","previous_item_id":null,"item_id":"item_3"})",
+        R"({"type":"input_audio_buffer.committed","previous_item_id":"item_3","item_id":"item_4"})",
+        R"({"type":"error","event_id":"event_4","error":{"type":"invalid_request_error","code":"bad","message":"Bad [thing] {here}","param":null}})",
+        R"({"type":"transcription_session.created","session":{"input_audio_format":"pcm16","turn_detection":{"type":"server_vad","threshold":0.5,"silence_duration_ms":500},"modalities":["text",["nested"]],"include":null,"enabled":true}})",
+        "{\n  \"type\" : \"input_audio_buffer.speech_started\",\n\t\"audio_start_ms\" : 1.5e3 ,\r\n  \"item_id\" : \"item_5\"\n}",
+        R"({"type":"error","type":"conversation.item.input_audio_transcription.delta","delta":"first","delta":"second","item_id":7,"error":{"message":"a"},"error":{"code":"b"}})",
+    };
+}
+
+static void testWholeEvents()
+{
+    for (const QString &message : corpus())
+    {
+        RealtimeEventScanner::Event scanned;
+        check(RealtimeEventScanner::scan(message, &scanned), "scan " + message);
+
+        const RealtimeEventScanner::Event parsed = RealtimeEventScanner::fromJson(QJsonDocument::fromJson(message.toUtf8()).object());
+        check(sameEvent(scanned, parsed), "fields of " + message);
+    }
+}
+
+static void testTornEvents()
+{
+    // A frame cut anywhere, or either half of it on its own, is never an event
+    for (const QString &message : corpus())
+    {
+        for (qsizetype cut = 1; cut < message.size(); ++cut)
+        {
+            RealtimeEventScanner::Event head;
+            check(!RealtimeEventScanner::scan(QStringView(message).first(cut), &head), QString("head of %1 at %2").arg(message).arg(cut));
+
+            RealtimeEventScanner::Event tail;
+            check(!RealtimeEventScanner::scan(QStringView(message).sliced(cut), &tail), QString("tail of %1 at %2").arg(message).arg(cut));
+        }
+    }
+
+    // Two frames run together are not one event either
+    const QStringList events = corpus();
+    RealtimeEventScanner::Event joined;
+    check(!RealtimeEventScanner::scan(events.at(0) + events.at(1), &joined), "concatenated frames");
+}
+
+static void testMutatedEvents()
+{
+    // Structural noise: whatever the scanner accepts must read the same as
+    // QJsonDocument wherever that accepts the input too
+    const QString noise = "{}[]\":,\\ 0ux";
+    QRandomGenerator random(41);
+
+    for (const QString &message : corpus())
+    {
+        for (int round = 0; round < 2000; ++round)
+        {
+            QString mutated = message;
+            const int edits = 1 + random.bounded(3);
+            for (int i = 0; i < edits && !mutated.isEmpty(); ++i)
+            {
+                const qsizetype at = random.bounded(int(mutated.size()));
+                const QChar c = noise.at(random.bounded(int(noise.size())));
+                switch (random.bounded(3))
+                {
+                case 0:
+                    mutated[at] = c;
+                    break;
+                case 1:
+                    mutated.insert(at, c);
+                    break;
+                default:
+                    mutated.remove(at, 1);
+                    break;
+                }
+            }
+
+            RealtimeEventScanner::Event scanned;
+            if (!RealtimeEventScanner::scan(mutated, &scanned))
+            {
+                continue;
+            }
+
+            QJsonParseError error;
+            const QJsonDocument document = QJsonDocument::fromJson(mutated.toUtf8(), &error);
+            if (error.error != QJsonParseError::NoError || !document.isObject())
+            {
+                continue;
+            }
+
+            check(sameEvent(scanned, RealtimeEventScanner::fromJson(document.object())), "fields of mutated " + mutated);
+        }
+    }
+}
+
+static void benchmark()
+{
+    // A long utterance is mostly small delta events
+    QStringList messages;
+    for (int i = 0; i < 1000; ++i)
+    {
+        messages << QString(R"({"type":"conversation.item.input_audio_transcription.delta","event_id":"event_%1","item_id":"item_%2","content_index":0,"delta":" word%1"})")
+                        .arg(i)
+                        .arg(i / 20);
+    }
+    const int rounds = 50;
+
+    QElapsedTimer timer;
+    timer.start();
+    qsizetype total = 0;
+    for (int round = 0; round < rounds; ++round)
+    {
+        for (const QString &message : std::as_const(messages))
+        {
+            RealtimeEventScanner::Event event;
+            RealtimeEventScanner::scan(message, &event);
+            total += event.delta.size();
+        }
+    }
+    const qint64 scanNs = qMax<qint64>(timer.nsecsElapsed(), 1);
+
+    // The path the transcriber took for every event before the scanner
+    timer.restart();
+    for (int round = 0; round < rounds; ++round)
+    {
+        for (const QString &message : std::as_const(messages))
+        {
+            const QJsonDocument document = QJsonDocument::fromJson(message.toUtf8());
+            total += RealtimeEventScanner::fromJson(document.object()).delta.size();
+        }
+    }
+    const qint64 jsonNs = qMax<qint64>(timer.nsecsElapsed(), 1);
+
+    const qint64 events = qint64(messages.size()) * rounds;
+    qInfo() << "RealtimeEventScanner::scan:" << scanNs / events << "ns/event,"
+            << "QJsonDocument::fromJson:" << jsonNs / events << "ns/event"
+            << "(" << total << "characters )";
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    testWholeEvents();
+    testTornEvents();
+    testMutatedEvents();
+    benchmark();
+
+    if (failures > 0)
+    {
+        qWarning() << failures << "checks failed";
+        return 1;
+    }
+
+    qInfo() << "All realtime event scanner checks passed";
+    return 0;
+}